@@ -42,6 +42,7 @@ namespace Protocol
 						auto pktinfo = reinterpret_cast<in_pktinfo *>(CMSG_DATA(cmsg));
 						Address address;
 						address.length = sizeof(address.data.in);
+						address.data.in = sockaddr_in{};
 						address.data.in.sin_family = AF_INET;
 						address.data.in.sin_addr = pktinfo->ipi_addr;
 						return address;
@@ -54,6 +55,7 @@ namespace Protocol
 						auto pktinfo = reinterpret_cast<in6_pktinfo *>(CMSG_DATA(cmsg));
 						Address address;
 						address.length = sizeof(address.data.in6);
+						address.data.in6 = sockaddr_in6{};
 						address.data.in6.sin6_family = AF_INET6;
 						address.data.in6.sin6_addr = pktinfo->ipi6_addr;
 						return address;
@@ -94,6 +96,23 @@ namespace Protocol
 			return addresses;
 		}
 		
+		bool Address::unspecified() const
+		{
+			switch (family()) {
+				case AF_INET: return data.in.sin_addr.s_addr == htonl(INADDR_ANY);
+				case AF_INET6: return IN6_IS_ADDR_UNSPECIFIED(&data.in6.sin6_addr);
+				default: return false;
+			}
+		}
+		
+		void Address::set_port(const Address & other)
+		{
+			switch (family()) {
+				case AF_INET: data.in.sin_port = other.data.in.sin_port; break;
+				case AF_INET6: data.in6.sin6_port = other.data.in6.sin6_port; break;
+			}
+		}
+		
 		Address::Address()
 		{
 			length = 0;
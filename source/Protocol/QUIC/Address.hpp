@@ -49,6 +49,10 @@ namespace Protocol
 			Address(const Destination & destination) : Address(destination.addr, destination.addrlen) {}
 			Address(const addrinfo * addr) : Address(addr->ai_addr, addr->ai_addrlen) {}
 			
+			Address(const Address & other) {
+				set(&other.data.sa, other.length);
+			}
+			
 			Address & operator=(const Address & other) {
 				set(&other.data.sa, other.length);
 				return *this;
@@ -69,6 +73,12 @@ namespace Protocol
 			
 			int family() const {return data.sa.sa_family;}
 			
+			// Whether this is the wildcard address (e.g. `0.0.0.0` or `::`), as used for binding to all interfaces.
+			bool unspecified() const;
+			
+			// Copy the port number from another address of the same family.
+			void set_port(const Address & other);
+			
 			std::string to_string() const;
 		};
 		
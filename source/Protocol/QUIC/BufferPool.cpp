@@ -0,0 +1,42 @@
+//
+//  BufferPool.cpp
+//  This file is part of the "Protocol::QUIC" project and released under the MIT License.
+//
+//  Created by Samuel Williams on 16/10/2026.
+//  Copyright, 2026, by Samuel Williams. All rights reserved.
+//
+
+#include "BufferPool.hpp"
+
+namespace Protocol
+{
+	namespace QUIC
+	{
+		BufferPool::BufferPool(std::size_t buffer_size, std::size_t limit) : _buffer_size(buffer_size), _limit(limit)
+		{
+		}
+		
+		BufferPool::~BufferPool()
+		{
+		}
+		
+		BufferPool::Buffer BufferPool::acquire()
+		{
+			if (_buffers.empty()) {
+				return std::make_unique<std::uint8_t[]>(_buffer_size);
+			}
+			
+			auto buffer = std::move(_buffers.back());
+			_buffers.pop_back();
+			
+			return buffer;
+		}
+		
+		void BufferPool::release(Buffer buffer)
+		{
+			if (buffer && _buffers.size() < _limit) {
+				_buffers.push_back(std::move(buffer));
+			}
+		}
+	}
+}
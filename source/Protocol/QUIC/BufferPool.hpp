@@ -0,0 +1,57 @@
+//
+//  BufferPool.hpp
+//  This file is part of the "Protocol::QUIC" project and released under the MIT License.
+//
+//  Created by Samuel Williams on 16/10/2026.
+//  Copyright, 2026, by Samuel Williams. All rights reserved.
+//
+
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+namespace Protocol
+{
+	namespace QUIC
+	{
+		// The BufferPool class recycles fixed size transmit buffers, so that packets can be written directly into memory which is handed to the kernel for zero-copy transmission. A buffer is only returned to the pool once the kernel has released it.
+		class BufferPool
+		{
+		public:
+			static constexpr std::size_t DEFAULT_BUFFER_SIZE = 1024*64;
+			
+			// The maximum number of idle buffers kept for reuse.
+			static constexpr std::size_t DEFAULT_LIMIT = 64;
+			
+			using Buffer = std::unique_ptr<std::uint8_t[]>;
+			
+			BufferPool(std::size_t buffer_size = DEFAULT_BUFFER_SIZE, std::size_t limit = DEFAULT_LIMIT);
+			~BufferPool();
+			
+			BufferPool(const BufferPool &) = delete;
+			BufferPool & operator=(const BufferPool &) = delete;
+			
+			BufferPool(BufferPool &&) = default;
+			BufferPool & operator=(BufferPool &&) = default;
+			
+			std::size_t buffer_size() const noexcept {return _buffer_size;}
+			
+			// The number of idle buffers in the pool.
+			std::size_t size() const noexcept {return _buffers.size();}
+			
+			// Take a buffer from the pool, allocating a new one if the pool is empty.
+			Buffer acquire();
+			
+			// Return a buffer to the pool. If the pool is full, the buffer is freed.
+			void release(Buffer buffer);
+			
+		private:
+			std::size_t _buffer_size;
+			std::size_t _limit;
+			
+			std::vector<Buffer> _buffers;
+		};
+	}
+}
@@ -8,6 +8,7 @@
 
 #include "BufferedStream.hpp"
 #include "Connection.hpp"
+#include "PacketTrain.hpp"
 
 #include <iostream>
 
@@ -41,13 +42,12 @@ namespace Protocol
 
 		Stream::Status BufferedStream::send_data()
 		{
+			PacketTrain train(_connection);
 			ngtcp2_path_storage path_storage;
 			ngtcp2_path_storage_zero(&path_storage);
 			ngtcp2_pkt_info packet_info;
 			ngtcp2_ssize written_length = 0;
 			
-			std::array<Byte, 1024*64> packet;
-			
 			StreamDataFlags flags = 0;
 			if (_output_buffer.closed()) {
 				flags |= NGTCP2_WRITE_STREAM_FLAG_FIN;
@@ -55,30 +55,35 @@ namespace Protocol
 			
 			auto chunks = _output_buffer.chunks();
 			
-			while (true) {
-				auto result = ngtcp2_conn_writev_stream(_connection.native_handle(), &path_storage.path, &packet_info, packet.data(), packet.size(), &written_length, flags, _stream_id, chunks.data(), chunks.size(), timestamp());
+			// Write as many packets as the connection allows, so they can be sent together as a train, unless the socket is backlogged:
+			while (!_connection.backlogged()) {
+				auto result = ngtcp2_conn_writev_stream(_connection.native_handle(), &path_storage.path, &packet_info, train.data(), train.available(), &written_length, flags, _stream_id, chunks.data(), chunks.size(), _connection.current_timestamp());
 				
 				if (result == NGTCP2_ERR_STREAM_SHUT_WR) {
 					_output_buffer.close();
 				}
 				
 				if (result < 0) {
+					train.flush();
 					return Status(result);
 				}
 				
 				if (written_length > 0) {
 					_output_buffer.increment(written_length);
+					chunks = _output_buffer.chunks();
 				}
 				
 				if (result > 0) {
-					_connection.send_packet(path_storage.path, packet_info, packet.data(), result);
+					train.append(path_storage.path, packet_info, result);
 				}
 				
-				if (written_length > 0 || chunks.empty()) {
+				if (result == 0 || chunks.empty()) {
 					break;
 				}
 			}
 			
+			train.flush();
+			
 			return Status::OK;
 		}
 		
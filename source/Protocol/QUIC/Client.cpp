@@ -11,6 +11,7 @@
 
 #include <stdexcept>
 #include <iostream>
+#include <string>
 
 #include "Scheduler/Handle.hpp"
 #include <Scheduler/After.hpp>
@@ -26,7 +27,7 @@ namespace Protocol
 		void Client::setup(TLS::ClientContext & tls_context, const ngtcp2_cid *dcid, const ngtcp2_cid *scid, const ngtcp2_path *path, std::uint32_t chosen_version, ngtcp2_settings *settings, ngtcp2_transport_params *params)
 		{
 			auto callbacks = ngtcp2_callbacks{};
-			Connection::setup(&callbacks, settings, params);
+			Connection::setup(&callbacks, settings, params, path);
 			
 			if (ngtcp2_conn_client_new(&_connection, dcid, scid, path, chosen_version, &callbacks, settings, params, nullptr, this)) {
 				throw std::runtime_error("Failed to create QUIC client connection!");
@@ -52,6 +53,17 @@ namespace Protocol
 			auto settings = ngtcp2_settings{};
 			ngtcp2_settings_default(&settings);
 			
+			// Present the token issued by the server during a previous connection, so that our address is validated from the first flight:
+			std::string token;
+			if (configuration.token_cache) {
+				token = configuration.token_cache->take(remote_address);
+				
+				if (!token.empty()) {
+					settings.token = reinterpret_cast<const std::uint8_t *>(token.data());
+					settings.tokenlen = token.size();
+				}
+			}
+			
 			auto params = ngtcp2_transport_params{};
 			ngtcp2_transport_params_default(&params);
 			
@@ -66,6 +78,14 @@ namespace Protocol
 		{
 		}
 		
+		void Client::receive_new_token(const Byte * token, std::size_t length)
+		{
+			if (_configuration.token_cache) {
+				auto path = ngtcp2_conn_get_path(_connection);
+				_configuration.token_cache->store(path->remote, token, length);
+			}
+		}
+		
 		void Client::drain()
 		{
 			auto duration = close_duration();
@@ -80,6 +100,11 @@ namespace Protocol
 		void Client::connect()
 		{
 			while (true) {
+				// If the socket is backlogged, wait for it to catch up before writing more packets:
+				if (!flush_transmit_queue()) {
+					handle_expiry();
+				}
+				
 				send_packets();
 				
 				auto path = ngtcp2_conn_get_path(_connection);
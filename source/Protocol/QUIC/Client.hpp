@@ -35,6 +35,9 @@ namespace Protocol
 			
 			void extend_maximum_local_bidirectional_streams(std::uint64_t maximum_streams) override;
 			
+			// Remember the token in `Configuration::token_cache`, if any, for the next connection to this server.
+			void receive_new_token(const Byte * token, std::size_t length) override;
+			
 		protected:
 			std::unique_ptr<TLS::ClientSession> _tls_session;
 			std::uint32_t _chosen_version;
@@ -9,6 +9,9 @@
 #include "Configuration.hpp"
 #include "Random.hpp"
 
+#include <fstream>
+#include <stdexcept>
+
 namespace Protocol
 {
 	namespace QUIC
@@ -22,8 +25,30 @@ namespace Protocol
 		{
 		}
 		
+		void Configuration::load_static_secret(const std::string & path)
+		{
+			std::ifstream input(path, std::ios::binary);
+			std::array<std::uint8_t, 32> secret;
+			
+			if (!input.read(reinterpret_cast<char *>(secret.data()), secret.size())) {
+				throw std::runtime_error("Failed to read static secret from " + path + "!");
+			}
+			
+			static_secret = secret;
+		}
+		
 		void Configuration::setup(ngtcp2_settings *settings, ngtcp2_transport_params *params)
 		{
+			if (max_tx_udp_payload_size) {
+				settings->max_tx_udp_payload_size = max_tx_udp_payload_size;
+			}
+			
+			settings->no_pmtud = !path_mtu_discovery;
+			
+			if (!path_mtu_probes.empty()) {
+				settings->pmtud_probes = path_mtu_probes.data();
+				settings->pmtud_probeslen = path_mtu_probes.size();
+			}
 		}
 	}
 }
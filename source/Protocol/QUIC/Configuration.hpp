@@ -8,8 +8,15 @@
 
 #pragma once
 
+#include "PathMTUCache.hpp"
+#include "ConnectionIDGenerator.hpp"
+#include "TokenCache.hpp"
+
 #include <array>
 #include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
 
 #include <ngtcp2/ngtcp2.h>
 
@@ -24,8 +31,101 @@ namespace Protocol
 			Configuration();
 			virtual ~Configuration();
 			
+			// The secret used to derive stateless reset tokens and address validation tokens. It is randomly generated by default, so tokens issued before a restart are no longer recognised; load a persistent secret to keep them valid, see `load_static_secret`.
 			std::array<std::uint8_t, 32> static_secret;
 			
+			// Load the static secret from a file, which must contain at least 32 bytes, e.g. generated by `head -c 32 /dev/urandom`. Every server sharing the secret can reset the others' connections, so it should be kept private.
+			void load_static_secret(const std::string & path);
+			
+			// The number of stateless reset packets which may be sent per second, per dispatcher, in response to packets for unknown connections. Zero disables stateless resets.
+			std::size_t stateless_reset_rate = 100;
+			
+			enum class Pacing {
+				// Packets are sent as soon as they are written, limited only by congestion control.
+				NONE,
+				
+				// After each packet train, the connection waits until ngtcp2's next transmission time (which is included in the connection's expiry) before writing more packets.
+				USER,
+				
+				// Packet trains are stamped with a departure time (`SO_TXTIME`) spaced at the connection's sending rate, and the kernel's fq qdisc paces them. User pacing is also applied, unless `kernel_pacing_confirmed` is set, and is used alone if the socket doesn't support departure times.
+				KERNEL,
+			};
+			
+			Pacing pacing = Pacing::NONE;
+			
+			// The kernel only honours departure times if the egress interface uses a qdisc which supports them (fq or etf); otherwise they are silently ignored. Set this once the qdisc has been configured, so that kernel pacing replaces user pacing rather than supplementing it.
+			bool kernel_pacing_confirmed = false;
+			
+			// After the handshake, move each server connection to its own UDP socket, bound to the same local address (`SO_REUSEPORT`) and connected to the client. The kernel then delivers the connection's packets directly to its socket, bypassing the dispatcher. The listening socket should also enable `Socket::set_reuse_port`. The kernel doesn't run `Socket::set_reuse_port_steering` programs for a group with connected sockets, so the two can't be combined.
+			bool connected_sockets = false;
+			
+			// The largest UDP payload which will be sent, once path MTU discovery has confirmed the path supports it. Zero uses ngtcp2's default (1452 bytes, which fits a 1500 byte Ethernet MTU). On networks with jumbo frames, set this to e.g. 8952 and include it in `path_mtu_probes`.
+			std::size_t max_tx_udp_payload_size = 0;
+			
+			// Probe the path for larger packet sizes (RFC 8899). If disabled, packets are limited to 1200 bytes unless the peer is in the `path_mtu_cache`, in which case its learned size is probed.
+			bool path_mtu_discovery = true;
+			
+			// The payload sizes to probe, in order. Sizes larger than `max_tx_udp_payload_size` are skipped. If empty, ngtcp2's defaults (up to 1500 bytes) are used.
+			std::vector<std::uint16_t> path_mtu_probes;
+			
+			// If set, remembers the payload size learned for each peer, so that new connections to the same peer probe that size first, rather than working up to it. May be shared between configurations.
+			std::shared_ptr<PathMTUCache> path_mtu_cache;
+			
+			// Generates the connection IDs used by servers, and determines the length used to decode short header packets. Use a `RoutableConnectionIDGenerator` so that load balancers can route packets by connection ID.
+			std::shared_ptr<ConnectionIDGenerator> connection_id_generator = std::make_shared<ConnectionIDGenerator>();
+			
+			enum class Retry {
+				// New connections are accepted without validating the client's address.
+				NEVER,
+				
+				// Clients must validate their address with a Retry packet while the rate of new connections exceeds `retry_threshold`, e.g. during a flood of spoofed Initial packets.
+				AUTOMATIC,
+				
+				// Clients must always validate their address with a Retry packet before a connection is created, at the cost of an extra round trip.
+				ALWAYS,
+			};
+			
+			Retry retry = Retry::AUTOMATIC;
+			
+			// The number of new connection attempts per second, per dispatcher, above which `Retry::AUTOMATIC` starts sending Retry packets.
+			std::size_t retry_threshold = 1000;
+			
+			// How long a Retry token remains valid, in nanoseconds.
+			std::uint64_t retry_token_timeout = 10ull * 1000 * 1000 * 1000;
+			
+			// The action taken when a source exceeds `rate_limit`.
+			enum class RateLimitAction {
+				// Drop the packet silently.
+				DROP,
+				
+				// Ask the client to validate its address with a Retry packet. Clients which have validated their address are accepted without being limited, so spoofed floods are stopped without refusing real clients.
+				RETRY,
+				
+				// Refuse the connection with a CONNECTION_CLOSE (CONNECTION_REFUSED), so that the client gives up rather than retransmitting.
+				REFUSE,
+			};
+			
+			// The number of new connections per second allowed from each source prefix, per dispatcher. Zero disables rate limiting. Packets for established connections, and new connections with a valid Retry or NEW_TOKEN token, are never limited. Must be set before creating dispatchers.
+			double rate_limit = 0;
+			
+			// The number of new connections allowed at once from each source prefix, which is accumulated while the prefix is tracked, see `RateLimiter`.
+			double rate_limit_burst = 32;
+			
+			// The prefix lengths used to group sources, see `RateLimiter`.
+			std::uint8_t rate_limit_ipv4_prefix_length = 24;
+			std::uint8_t rate_limit_ipv6_prefix_length = 56;
+			
+			RateLimitAction rate_limit_action = RateLimitAction::RETRY;
+			
+			// Issue an address validation token (NEW_TOKEN frame) to each client once the handshake has completed. A client presenting the token when it reconnects is treated as validated from its first flight, avoiding both a Retry packet and the anti-amplification limit.
+			bool new_tokens = true;
+			
+			// How long an address validation token remains valid, in nanoseconds.
+			std::uint64_t new_token_timeout = 3600ull * 1000 * 1000 * 1000;
+			
+			// If set, clients remember the tokens issued by each server and present them when reconnecting. May be shared between configurations.
+			std::shared_ptr<TokenCache> token_cache;
+			
 			virtual void setup(ngtcp2_settings *settings, ngtcp2_transport_params *params);
 		};
 	}
@@ -9,10 +9,12 @@
 #include "Connection.hpp"
 #include "BufferedStream.hpp"
 #include "Configuration.hpp"
+#include "PacketTrain.hpp"
 #include "Random.hpp"
 
 #include <Time/Interval.hpp>
 
+#include <algorithm>
 #include <chrono>
 #include <array>
 #include <ngtcp2/ngtcp2.h>
@@ -22,6 +24,7 @@
 #include <iostream>
 #include <iomanip>
 #include <stdio.h>
+#include <time.h>
 
 namespace Protocol
 {
@@ -68,8 +71,27 @@ namespace Protocol
 		{
 			disconnect();
 			
-			if (_connection)
+			if (_connection) {
+				remember_path_mtu();
 				ngtcp2_conn_del(_connection);
+			}
+		}
+		
+		void Connection::remember_path_mtu()
+		{
+			if (!_path_mtu_discovery || !_configuration.path_mtu_cache) return;
+			
+			auto path = ngtcp2_conn_get_path(_connection);
+			auto size = ngtcp2_conn_get_path_max_tx_udp_payload_size(_connection);
+			
+			// ngtcp2 doesn't send packets larger than the minimum until a probe has been acknowledged, so a larger size was confirmed by path MTU discovery:
+			if (size > NGTCP2_MAX_UDP_PAYLOAD_SIZE) {
+				_configuration.path_mtu_cache->update(path->remote, size);
+			}
+			// The connection may have closed before path MTU discovery started, which says nothing about the path, unless every probe of the learned size was sent without being acknowledged:
+			else if (_learned_path_mtu && _learned_path_mtu_probes >= PATH_MTU_PROBE_ATTEMPTS) {
+				_configuration.path_mtu_cache->erase(path->remote);
+			}
 		}
 		
 		void Connection::disconnect()
@@ -88,7 +110,7 @@ namespace Protocol
 			ngtcp2_path_storage_zero(&path_storage);
 			ngtcp2_pkt_info packet_info;
 			
-			auto result = ngtcp2_conn_write_connection_close(_connection, &path_storage.path, &packet_info, packet.data(), packet.size(), &_last_error, timestamp());
+			auto result = ngtcp2_conn_write_connection_close(_connection, &path_storage.path, &packet_info, packet.data(), packet.size(), &_last_error, current_timestamp());
 			
 			if (result < 0) {
 				throw std::system_error(result, ngtcp2_category(), "ngtcp2_conn_write_connection_close");
@@ -98,7 +120,7 @@ namespace Protocol
 			
 			if (socket) {
 				auto expiry_timeout = this->expiry_timeout();
-				socket->send_packet(packet.data(), result, path_storage.path.remote, ECN(packet_info.ecn), extract_optional(expiry_timeout));
+				socket->send_packet(packet.data(), result, path_storage.path.remote, ECN(packet_info.ecn), extract_optional(expiry_timeout), 0, 0, &path_storage.path.local);
 			}
 			
 			disconnect();
@@ -106,7 +128,7 @@ namespace Protocol
 		
 		void Connection::handle_expiry()
 		{
-			auto now = timestamp();
+			auto now = current_timestamp();
 			auto result = ngtcp2_conn_handle_expiry(_connection, now);
 			
 			if (result < 0) {
@@ -213,6 +235,24 @@ namespace Protocol
 		{
 		}
 		
+		int receive_new_token_callback(ngtcp2_conn *conn, const uint8_t *token, size_t tokenlen, void *user_data)
+		{
+			Connection *connection = reinterpret_cast<Connection*>(user_data);
+			
+			try {
+				connection->receive_new_token(token, tokenlen);
+			} catch (std::exception & error) {
+				std::cerr << "receive_new_token_callback: " << error.what() << std::endl;
+				return NGTCP2_ERR_CALLBACK_FAILURE;
+			}
+			
+			return 0;
+		}
+		
+		void Connection::receive_new_token(const Byte * token, std::size_t length)
+		{
+		}
+		
 		int extend_max_local_streams_bidi_callback(ngtcp2_conn *conn, uint64_t max_streams, void *user_data)
 		{
 			Connection *connection = reinterpret_cast<Connection*>(user_data);
@@ -378,28 +418,51 @@ namespace Protocol
 			return 0;
 		}
 		
+		bool Connection::backlogged()
+		{
+			auto socket = static_cast<Socket *>(ngtcp2_conn_get_path(_connection)->user_data);
+			
+			return socket && socket->backlogged();
+		}
+		
+		bool Connection::flush_transmit_queue()
+		{
+			auto socket = static_cast<Socket *>(ngtcp2_conn_get_path(_connection)->user_data);
+			
+			if (!socket) return true;
+			
+			auto timeout = expiry_timeout();
+			
+			return socket->flush_transmit_queue(extract_optional(timeout));
+		}
+		
 		Connection::Status Connection::send_packets()
 		{
-			std::array<Byte, 1024*64> packet;
+			PacketTrain train(*this);
 			ngtcp2_path_storage path_storage;
 			ngtcp2_path_storage_zero(&path_storage);
 			ngtcp2_pkt_info packet_info;
 			ngtcp2_ssize written_length = 0;
 			StreamDataFlags flags = 0;
 			
-			while (true) {
-				auto result = ngtcp2_conn_write_stream(_connection, &path_storage.path, &packet_info, packet.data(), packet.size(), &written_length, flags, -1, nullptr, 0, timestamp());
+			while (!backlogged()) {
+				auto result = ngtcp2_conn_write_stream(_connection, &path_storage.path, &packet_info, train.data(), train.available(), &written_length, flags, -1, nullptr, 0, current_timestamp());
 				
-				if (result < 0) return Status(result);
+				if (result < 0) {
+					train.flush();
+					return Status(result);
+				}
 				
 				if (result > 0) {
-					send_packet(path_storage.path, packet_info, packet.data(), result);
+					train.append(path_storage.path, packet_info, result);
 				}
 				else {
 					break;
 				}
 			}
 			
+			train.flush();
+			
 			return send_stream_data();
 		}
 		
@@ -412,34 +475,103 @@ namespace Protocol
 			return Status::OK;
 		}
 		
-		void Connection::send_packet(const ngtcp2_path &path, const ngtcp2_pkt_info &packet_info, const Byte *data, std::size_t size)
+		void Connection::send_packet(const ngtcp2_path &path, const ngtcp2_pkt_info &packet_info, const Byte *data, std::size_t size, std::size_t segment_size)
 		{
 			auto timeout = expiry_timeout();
 			auto & socket = *reinterpret_cast<Socket*>(path.user_data);
+			auto departure_time = this->departure_time(socket, size);
+			
+			auto sent_size = socket.send_packet(data, size, path.remote, static_cast<ECN>(packet_info.ecn), extract_optional(timeout), segment_size, departure_time, &path.local);
+			
+			update_transmit_time(departure_time);
 
-			auto sent_size = socket.send_packet(data, size, path.remote, static_cast<ECN>(packet_info.ecn), extract_optional(timeout));
-
+			// The socket's transmit queue was full and the connection expired before it could be sent, so it will be retransmitted by loss recovery:
 			if (!sent_size) {
 				handle_expiry();
 			}
+		}
 
-			if (sent_size != size) {
-				throw std::runtime_error("send_packet failed");
+		void Connection::send_packet(const ngtcp2_path &path, const ngtcp2_pkt_info &packet_info, BufferPool::Buffer buffer, std::size_t size, std::size_t segment_size)
+		{
+			auto timeout = expiry_timeout();
+			auto & socket = *reinterpret_cast<Socket*>(path.user_data);
+			auto departure_time = this->departure_time(socket, size);
+			
+			auto sent_size = socket.send_buffer(std::move(buffer), size, path.remote, static_cast<ECN>(packet_info.ecn), extract_optional(timeout), segment_size, departure_time, &path.local);
+			
+			update_transmit_time(departure_time);
+			
+			// See above:
+			if (!sent_size) {
+				handle_expiry();
 			}
 		}
-
+		
+		std::uint64_t Connection::departure_time(Socket & socket, std::size_t size)
+		{
+			if (_configuration.pacing != Configuration::Pacing::KERNEL) return 0;
+			
+			if (!socket.transmit_time() && !socket.set_transmit_time(true)) return 0;
+			
+			ngtcp2_conn_info info;
+			ngtcp2_conn_get_conn_info(_connection, &info);
+			
+			timespec now;
+			clock_gettime(CLOCK_MONOTONIC, &now);
+			
+			auto departure_time = std::max<std::uint64_t>(_departure_time, now.tv_sec * 1000000000ull + now.tv_nsec);
+			
+			if (info.cwnd > 0) {
+				_departure_time = departure_time + (size * info.smoothed_rtt / info.cwnd);
+			}
+			
+			return departure_time;
+		}
+		
+		void Connection::update_transmit_time(std::uint64_t departure_time)
+		{
+			if (_configuration.pacing == Configuration::Pacing::NONE) return;
+			
+			// The kernel paces packets which have a departure time, so ngtcp2 doesn't need to delay the next packet, but only if the qdisc is known to honour them:
+			if (departure_time && _configuration.kernel_pacing_confirmed) return;
+			
+			ngtcp2_conn_update_pkt_tx_time(_connection, current_timestamp());
+		}
+		
+		ngtcp2_tstamp Connection::current_timestamp()
+		{
+			return _last_timestamp = timestamp();
+		}
+		
+		ngtcp2_tstamp Connection::receive_timestamp(std::uint64_t receive_time)
+		{
+			auto now = timestamp();
+			
+			if (receive_time == 0 || receive_time > now) {
+				return _last_timestamp = now;
+			}
+			
+			// Smoothed in the same way as the round trip time (RFC 9002):
+			_queuing_delay = (_queuing_delay * 7 + (now - receive_time)) / 8;
+			
+			// ngtcp2 requires timestamps which never go backwards, but the packet may have been received before the connection last wrote packets or handled its expiry:
+			_last_timestamp = std::max<ngtcp2_tstamp>(receive_time, _last_timestamp);
+			
+			return _last_timestamp;
+		}
+		
 		Connection::Status Connection::receive_packets(const ngtcp2_path & path, Socket & socket, std::size_t count)
 		{
-			std::array<std::uint8_t, 1024*64> buffer;
+			if (!_receive_batch) {
+				_receive_batch = std::make_unique<ReceiveBatch>();
+			}
+			
+			auto & batch = *_receive_batch;
 			
 			while (count > 0) {
-				ECN ecn = ECN::UNSPECIFIED;
-				Address remote_address;
 				auto timeout = expiry_timeout();
 				
-				auto size = socket.receive_packet(buffer.data(), buffer.size(), remote_address, ecn, extract_optional(timeout));
-				
-				if (!size) {
+				if (!socket.receive_packets(batch, extract_optional(timeout))) {
 					handle_expiry();
 					
 					if (is_draining() || is_closing())
@@ -449,22 +581,32 @@ namespace Protocol
 					continue;
 				}
 				
-				auto packet_info = ngtcp2_pkt_info{
-					.ecn = static_cast<std::uint8_t>(ecn),
-				};
-				
-				auto result = ngtcp2_conn_read_pkt(_connection, &path, &packet_info, buffer.data(), size, timestamp());
-				
-				if (result < 0) {
-					return handle_error(result, "ngtcp2_conn_read_pkt");
+				// Process the entire batch before waiting on the socket again:
+				while (auto packet = batch.next()) {
+					if (!(packet->remote_address == path.remote) && redirect_packet(socket, *packet)) continue;
+					
+					auto packet_info = ngtcp2_pkt_info{
+						.ecn = static_cast<std::uint8_t>(packet->ecn),
+					};
+					
+					auto result = ngtcp2_conn_read_pkt(_connection, &path, &packet_info, packet->data, packet->size, receive_timestamp(packet->receive_time));
+					
+					if (result < 0) {
+						return handle_error(result, "ngtcp2_conn_read_pkt");
+					}
+					
+					if (count > 0) count -= 1;
 				}
-				
-				count -= 1;
 			}
 			
 			return Status::OK;
 		}
 		
+		bool Connection::redirect_packet(Socket & socket, const ReceiveBatch::Packet & packet)
+		{
+			return false;
+		}
+		
 		Connection::Status Connection::receive_packets(const ngtcp2_path & path, std::size_t count)
 		{
 			auto & socket = *reinterpret_cast<Socket*>(path.user_data);
@@ -508,10 +650,33 @@ namespace Protocol
 			std::cerr << *connection << " ngtcp2: " << buffer << std::endl;
 		}
 		
-		void Connection::setup(ngtcp2_callbacks *callbacks, ngtcp2_settings *settings, ngtcp2_transport_params *params)
+		// The payload sizes probed after a learned size, if none are configured: Ethernet, tunnels, and the IPv6 minimum MTU, less the IPv6 and UDP headers.
+		static const std::uint16_t FALLBACK_PATH_MTU_PROBES[] = {1452, 1342, 1232};
+		
+		void Connection::setup(ngtcp2_callbacks *callbacks, ngtcp2_settings *settings, ngtcp2_transport_params *params, const ngtcp2_path *path)
 		{
 			_configuration.setup(settings, params);
 			
+			if (path && _configuration.path_mtu_cache) {
+				if (auto size = _configuration.path_mtu_cache->lookup(path->remote)) {
+					// Probe the learned size first, so that it's confirmed by the first probe rather than working up to it. The path may have changed since it was learned, so packets still start at the minimum size, and if the probe is lost, ngtcp2 falls back to the remaining sizes:
+					_path_mtu_probes.assign(1, size);
+					_learned_path_mtu = size;
+					
+					if (settings->pmtud_probeslen) {
+						_path_mtu_probes.insert(_path_mtu_probes.end(), settings->pmtud_probes, settings->pmtud_probes + settings->pmtud_probeslen);
+					} else {
+						_path_mtu_probes.insert(_path_mtu_probes.end(), std::begin(FALLBACK_PATH_MTU_PROBES), std::end(FALLBACK_PATH_MTU_PROBES));
+					}
+					
+					settings->pmtud_probes = _path_mtu_probes.data();
+					settings->pmtud_probeslen = _path_mtu_probes.size();
+					settings->no_pmtud = 0;
+				}
+			}
+			
+			_path_mtu_discovery = !settings->no_pmtud;
+			
 			// Setup the random data generator:
 			settings->rand_ctx.native_handle = reinterpret_cast<void*>(&_random);
 			callbacks->rand = random_callback;
@@ -531,6 +696,7 @@ namespace Protocol
 			callbacks->version_negotiation = ngtcp2_crypto_version_negotiation_cb;
 			
 			callbacks->handshake_completed = handshake_completed_callback;
+			callbacks->recv_new_token = receive_new_token_callback;
 			
 			callbacks->extend_max_local_streams_bidi = extend_max_local_streams_bidi_callback;
 			callbacks->extend_max_local_streams_uni = extend_max_local_streams_uni_callback;
@@ -544,7 +710,7 @@ namespace Protocol
 			callbacks->recv_stream_data = receive_stream_data_callback;
 			callbacks->acked_stream_data_offset = acked_stream_data_offset_callback;
 			
-			settings->initial_ts = timestamp();
+			settings->initial_ts = current_timestamp();
 			// settings->log_printf = log_printf;
 			
 			params->initial_max_stream_data_bidi_local = 128 * 1024;
@@ -10,7 +10,9 @@
 
 #include "Stream.hpp"
 #include "Socket.hpp"
+#include "ReceiveBatch.hpp"
 #include "Random.hpp"
+#include "ConnectionIDGenerator.hpp"
 #include "TLS/Session.hpp"
 
 #include <system_error>
@@ -29,8 +31,6 @@ namespace Protocol
 		
 		typedef ngtcp2_ccerr ngtcp2_connection_close_error;
 		
-		constexpr size_t DEFAULT_SCID_LENGTH = 8;
-		
 		ngtcp2_tstamp timestamp();
 		
 		template <typename OptionalType>
@@ -45,7 +45,7 @@ namespace Protocol
 		class Connection
 		{
 		public:
-			void generate_cid(ngtcp2_cid *cid, std::size_t length = DEFAULT_SCID_LENGTH);
+			virtual void generate_cid(ngtcp2_cid *cid, std::size_t length = DEFAULT_SCID_LENGTH);
 			
 			Connection(Configuration & configuration, ngtcp2_conn * connection = nullptr);
 			virtual ~Connection();
@@ -99,6 +99,9 @@ namespace Protocol
 			
 			virtual void handshake_completed();
 			
+			// The server issued an address validation token (NEW_TOKEN frame) for future connections.
+			virtual void receive_new_token(const Byte * token, std::size_t length);
+			
 			// This is often used as an entry point to create new streams:
 			virtual void extend_maximum_local_bidirectional_streams(std::uint64_t maximum_streams);
 			virtual void extend_maximum_local_unidirectional_streams(std::uint64_t maximum_streams);
@@ -112,14 +115,55 @@ namespace Protocol
 			
 			void set_last_error(int result, std::string_view reason = "");
 			
+			// Whether the socket for the current path has queued packets which it couldn't send yet, in which case no more packets should be written until it has caught up (backpressure).
+			bool backlogged();
+			
+			// Wait until the socket for the current path has sent its queued packets, or the connection expires.
+			// @returns whether the queue was flushed.
+			bool flush_transmit_queue();
+			
+			// Write and send packets until ngtcp2 has nothing more to send, or the socket is backlogged.
 			Status send_packets();
 			virtual Status send_stream_data();
-			void send_packet(const ngtcp2_path &path, const ngtcp2_pkt_info &packet_info, const Byte *data, std::size_t size);
 			
-			// Receive packets from the specified path.
+			// Send a packet, or a train of packets of `segment_size` bytes each (the last may be shorter), to the specified path.
+			void send_packet(const ngtcp2_path &path, const ngtcp2_pkt_info &packet_info, const Byte *data, std::size_t size, std::size_t segment_size = 0);
+			
+			// Send a packet (or packet train) from a buffer acquired from the socket's buffer pool. The socket takes ownership of the buffer, so that it can be transmitted without copying.
+			void send_packet(const ngtcp2_path &path, const ngtcp2_pkt_info &packet_info, BufferPool::Buffer buffer, std::size_t size, std::size_t segment_size = 0);
+			
+			// The time at which a packet of the given size should leave the socket, when using kernel pacing. Successive packets are spaced at the connection's sending rate (congestion window / smoothed round trip time).
+			// @returns the departure time in nanoseconds on the monotonic clock, or 0 if the packet should be sent immediately.
+			std::uint64_t departure_time(Socket & socket, std::size_t size);
+			
+			// Inform ngtcp2 that a packet train was sent, so that it can schedule the next transmission when pacing.
+			// @parameter departure_time the departure time of the packet train, if it is paced by the kernel.
+			void update_transmit_time(std::uint64_t departure_time);
+			
+			// The smoothed time between the kernel receiving a packet and the connection processing it, which is the delay added by the host (socket queue and dispatch) rather than the network.
+			ngtcp2_duration queuing_delay() const noexcept {return _queuing_delay;}
+			
+			// The current time, for use with ngtcp2 functions, which is remembered so that later timestamps never go backwards.
+			ngtcp2_tstamp current_timestamp();
+			
+			// Determine the timestamp of a received packet, for use with `ngtcp2_conn_read_pkt`, so that time spent queued on the host doesn't inflate round trip time samples. The timestamp is never earlier than one already given to the connection.
+			// @parameter receive_time the time at which the kernel received the packet, or 0 if it's not known.
+			ngtcp2_tstamp receive_timestamp(std::uint64_t receive_time);
+			
+			// Called for each packet written by ngtcp2, to count the probes of the size learned for the peer. Until a probe is acknowledged, only probes are larger than the minimum size.
+			void packet_written(std::size_t size) noexcept
+			{
+				if (size == _learned_path_mtu) _learned_path_mtu_probes += 1;
+			}
+			
+			// Receive packets from the specified path. Packets are received in batches, and each batch is processed completely, so more than `count` packets may be processed.
 			Status receive_packets(const ngtcp2_path & path, Socket & socket, std::size_t count = 1);
 			Status receive_packets(const ngtcp2_path & path, std::size_t count = 1);
 			
+			// Called by `receive_packets` for each packet received from an address other than the path's remote address, e.g. because the peer migrated. By default, the packet is processed by this connection.
+			// @returns whether the packet was handled elsewhere, in which case this connection ignores it.
+			virtual bool redirect_packet(Socket & socket, const ReceiveBatch::Packet & packet);
+			
 			virtual void print(std::ostream & output) const;
 			
 		protected:
@@ -130,12 +174,40 @@ namespace Protocol
 			
 			Random _random;
 			
+			// The departure time of the next packet, when using kernel pacing:
+			std::uint64_t _departure_time = 0;
+			
+			ngtcp2_duration _queuing_delay = 0;
+			
+			// The latest timestamp given to ngtcp2, see `current_timestamp`:
+			ngtcp2_tstamp _last_timestamp = 0;
+			
+			// Whether path MTU discovery is probing this connection's path, in which case the learned size is recorded in the configuration's `path_mtu_cache`:
+			bool _path_mtu_discovery = false;
+			
+			// The payload sizes to probe, starting with the size learned for the peer, see `setup`:
+			std::vector<std::uint16_t> _path_mtu_probes;
+			
+			// The size learned for the peer, if any, and the number of packets of that size which were sent, see `remember_path_mtu`:
+			std::size_t _learned_path_mtu = 0;
+			std::size_t _learned_path_mtu_probes = 0;
+			
+			// Allocated on first use by `receive_packets`:
+			std::unique_ptr<ReceiveBatch> _receive_batch;
+			
 			std::unordered_map<StreamID, Stream *> _streams;
 			Stream *open_stream(StreamID stream_id);
 			virtual Stream * create_stream(StreamID stream_id) = 0;
 			
 			// Setup default callbacks and related settings.
-			void setup(ngtcp2_callbacks *callbacks, ngtcp2_settings *settings, ngtcp2_transport_params *params);
+			// @parameter path The initial path, used to look up the learned path MTU of the peer.
+			void setup(ngtcp2_callbacks *callbacks, ngtcp2_settings *settings, ngtcp2_transport_params *params, const ngtcp2_path *path = nullptr);
+			
+			// The number of times ngtcp2 sends a probe before trying the next size.
+			static constexpr std::size_t PATH_MTU_PROBE_ATTEMPTS = 3;
+			
+			// Record the maximum UDP payload size confirmed by path MTU discovery in the configuration's `path_mtu_cache`, or forget the learned size if its probes were lost.
+			void remember_path_mtu();
 		};
 		
 		std::ostream & operator<<(std::ostream & output, const Connection & connection);
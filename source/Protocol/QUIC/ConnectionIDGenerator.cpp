@@ -0,0 +1,142 @@
+//
+//  ConnectionIDGenerator.cpp
+//  This file is part of the "Protocol::QUIC" project and released under the MIT License.
+//
+//  Created by Samuel Williams on 16/10/2026.
+//  Copyright, 2026, by Samuel Williams. All rights reserved.
+//
+
+#include "ConnectionIDGenerator.hpp"
+#include "Random.hpp"
+
+#include <algorithm>
+#include <stdexcept>
+
+namespace Protocol
+{
+	namespace QUIC
+	{
+		ConnectionIDGenerator::ConnectionIDGenerator(std::size_t length) : _length(length)
+		{
+			if (length == 0 || length > NGTCP2_MAX_CIDLEN) {
+				throw std::invalid_argument("Invalid connection ID length!");
+			}
+		}
+		
+		ConnectionIDGenerator::~ConnectionIDGenerator()
+		{
+		}
+		
+		void ConnectionIDGenerator::generate(ngtcp2_cid * cid, std::size_t worker, std::size_t workers) const
+		{
+			Random::generate_secure(cid->data, _length);
+			cid->datalen = _length;
+			
+			if (workers > 1) {
+				cid->data[worker_offset()] = worker;
+			}
+		}
+		
+		RoutableConnectionIDGenerator::RoutableConnectionIDGenerator(std::uint8_t configuration, std::vector<std::uint8_t> server_id, std::size_t length) : ConnectionIDGenerator(length), _configuration(configuration), _server_id(std::move(server_id))
+		{
+			if (_configuration >= UNROUTABLE) {
+				throw std::invalid_argument("Invalid config rotation codepoint!");
+			}
+			
+			if (_server_id.empty() || _server_id.size() > 15) {
+				throw std::invalid_argument("Invalid server ID length!");
+			}
+			
+			if (length < 1 + _server_id.size() + MINIMUM_NONCE_LENGTH) {
+				throw std::invalid_argument("Connection ID length is too short for the server ID and nonce!");
+			}
+		}
+		
+		RoutableConnectionIDGenerator::RoutableConnectionIDGenerator(std::uint8_t configuration, std::vector<std::uint8_t> server_id, std::size_t length, const Key & key) : RoutableConnectionIDGenerator(configuration, std::move(server_id), length)
+		{
+			if (length != 1 + 16) {
+				throw std::invalid_argument("Encrypted connection IDs must be 17 bytes long!");
+			}
+			
+			_encrypted = true;
+			
+			_encrypt_context = EVP_CIPHER_CTX_new();
+			_decrypt_context = EVP_CIPHER_CTX_new();
+			
+			if (_encrypt_context == nullptr || _decrypt_context == nullptr) {
+				EVP_CIPHER_CTX_free(_encrypt_context);
+				EVP_CIPHER_CTX_free(_decrypt_context);
+				
+				throw std::runtime_error("EVP_CIPHER_CTX_new failed!");
+			}
+			
+			if (EVP_CipherInit_ex(_encrypt_context, EVP_aes_128_ecb(), nullptr, key.data(), nullptr, 1) != 1 || EVP_CipherInit_ex(_decrypt_context, EVP_aes_128_ecb(), nullptr, key.data(), nullptr, 0) != 1) {
+				EVP_CIPHER_CTX_free(_encrypt_context);
+				EVP_CIPHER_CTX_free(_decrypt_context);
+				
+				throw std::runtime_error("EVP_CipherInit_ex failed!");
+			}
+			
+			EVP_CIPHER_CTX_set_padding(_encrypt_context, 0);
+			EVP_CIPHER_CTX_set_padding(_decrypt_context, 0);
+		}
+		
+		RoutableConnectionIDGenerator::~RoutableConnectionIDGenerator()
+		{
+			EVP_CIPHER_CTX_free(_encrypt_context);
+			EVP_CIPHER_CTX_free(_decrypt_context);
+		}
+		
+		void RoutableConnectionIDGenerator::generate(ngtcp2_cid * cid, std::size_t worker, std::size_t workers) const
+		{
+			if (workers > maximum_workers()) {
+				throw std::logic_error("Encrypted connection IDs can't be routed to a worker!");
+			}
+			
+			auto data = cid->data;
+			
+			data[0] = (_configuration << 5) | ((_length - 1) & 0x1f);
+			std::copy(_server_id.begin(), _server_id.end(), data + 1);
+			
+			auto nonce = data + 1 + _server_id.size();
+			Random::generate_secure(nonce, _length - 1 - _server_id.size());
+			
+			if (workers > 1) {
+				nonce[0] = worker;
+			}
+			
+			if (_encrypted) {
+				transform(data + 1, true);
+			}
+			
+			cid->datalen = _length;
+		}
+		
+		bool RoutableConnectionIDGenerator::decode(const std::uint8_t * cid, std::size_t length, std::uint8_t * server_id) const
+		{
+			if (length != _length || (cid[0] >> 5) != _configuration) return false;
+			
+			if (_encrypted) {
+				std::array<std::uint8_t, 16> block;
+				std::copy_n(cid + 1, block.size(), block.data());
+				
+				transform(block.data(), false);
+				std::copy_n(block.data(), _server_id.size(), server_id);
+			} else {
+				std::copy_n(cid + 1, _server_id.size(), server_id);
+			}
+			
+			return true;
+		}
+		
+		void RoutableConnectionIDGenerator::transform(std::uint8_t * block, bool encrypt) const
+		{
+			std::lock_guard<std::mutex> guard(_mutex);
+			
+			int length = 0;
+			if (EVP_CipherUpdate(encrypt ? _encrypt_context : _decrypt_context, block, &length, block, 16) != 1 || length != 16) {
+				throw std::runtime_error("EVP_CipherUpdate failed!");
+			}
+		}
+	}
+}
@@ -0,0 +1,101 @@
+//
+//  ConnectionIDGenerator.hpp
+//  This file is part of the "Protocol::QUIC" project and released under the MIT License.
+//
+//  Created by Samuel Williams on 16/10/2026.
+//  Copyright, 2026, by Samuel Williams. All rights reserved.
+//
+
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <mutex>
+#include <vector>
+
+#include <ngtcp2/ngtcp2.h>
+#include <openssl/evp.h>
+
+namespace Protocol
+{
+	namespace QUIC
+	{
+		constexpr std::size_t DEFAULT_SCID_LENGTH = 8;
+		
+		// The ConnectionIDGenerator class generates the connection IDs used by servers, see `Configuration::connection_id_generator`. The default implementation generates random connection IDs of a fixed length. In a sharded server, the index of the worker which owns the connection is stored in the byte at `worker_offset`, so that packets can be routed to it (see `Distributor` and `Socket::set_reuse_port_steering`).
+		class ConnectionIDGenerator
+		{
+		public:
+			ConnectionIDGenerator(std::size_t length = DEFAULT_SCID_LENGTH);
+			virtual ~ConnectionIDGenerator();
+			
+			// The length of the generated connection IDs, which is also used to decode short header packets.
+			std::size_t length() const noexcept {return _length;}
+			
+			// The offset of the byte which holds the worker index.
+			virtual std::size_t worker_offset() const noexcept {return 0;}
+			
+			// The maximum number of workers which connections can be routed to, which is checked when a dispatcher or distributor is set up, see `Dispatcher::set_worker`.
+			virtual std::size_t maximum_workers() const noexcept {return 256;}
+			
+			// Generate a connection ID.
+			// @parameter worker the index of the worker which owns the connection, which is encoded if there is more than one worker.
+			virtual void generate(ngtcp2_cid * cid, std::size_t worker = 0, std::size_t workers = 1) const;
+			
+		protected:
+			std::size_t _length;
+		};
+		
+		// Generates connection IDs which a load balancer can route to this server without keeping any state, in the format described by QUIC-LB (draft-ietf-quic-load-balancers). The first octet holds the config rotation codepoint in its three most significant bits, and the length of the rest of the connection ID in the remaining five bits. It is followed by the server ID and a random nonce. If a key is given, the server ID and nonce are encrypted with AES-128 in a single pass, which requires them to be exactly 16 bytes together (a connection ID length of 17).
+		class RoutableConnectionIDGenerator : public ConnectionIDGenerator
+		{
+		public:
+			using Key = std::array<std::uint8_t, 16>;
+			
+			// The config rotation codepoint reserved for connection IDs which can't be routed.
+			static constexpr std::uint8_t UNROUTABLE = 0x07;
+			
+			// The minimum length of the nonce.
+			static constexpr std::size_t MINIMUM_NONCE_LENGTH = 4;
+			
+			// @parameter configuration the config rotation codepoint, from 0 to 6.
+			// @parameter server_id identifies this server to the load balancer, from 1 to 15 bytes.
+			// @parameter length the length of the connection IDs, which must leave room for the nonce.
+			RoutableConnectionIDGenerator(std::uint8_t configuration, std::vector<std::uint8_t> server_id, std::size_t length);
+			RoutableConnectionIDGenerator(std::uint8_t configuration, std::vector<std::uint8_t> server_id, std::size_t length, const Key & key);
+			virtual ~RoutableConnectionIDGenerator();
+			
+			RoutableConnectionIDGenerator(const RoutableConnectionIDGenerator &) = delete;
+			RoutableConnectionIDGenerator & operator=(const RoutableConnectionIDGenerator &) = delete;
+			
+			std::uint8_t configuration() const noexcept {return _configuration;}
+			const std::vector<std::uint8_t> & server_id() const noexcept {return _server_id;}
+			bool encrypted() const noexcept {return _encrypted;}
+			
+			// The worker index is stored in the first byte of the nonce. Encrypted connection IDs can't be routed to a worker without the key, so they only support one worker.
+			std::size_t worker_offset() const noexcept override {return 1 + _server_id.size();}
+			std::size_t maximum_workers() const noexcept override {return _encrypted ? 1 : 256;}
+			
+			void generate(ngtcp2_cid * cid, std::size_t worker = 0, std::size_t workers = 1) const override;
+			
+			// Extract the server ID from a connection ID generated with the same configuration, as a load balancer would.
+			// @parameter server_id receives `server_id().size()` bytes.
+			// @returns whether the connection ID uses this configuration.
+			bool decode(const std::uint8_t * cid, std::size_t length, std::uint8_t * server_id) const;
+			
+		private:
+			std::uint8_t _configuration;
+			std::vector<std::uint8_t> _server_id;
+			
+			bool _encrypted = false;
+			
+			// Initialised once with the key, as ECB mode keeps no state between blocks. The contexts are shared by every call, e.g. from a load balancer decoding connection IDs on another thread, so access is serialized:
+			EVP_CIPHER_CTX * _encrypt_context = nullptr;
+			EVP_CIPHER_CTX * _decrypt_context = nullptr;
+			mutable std::mutex _mutex;
+			
+			// Encrypt or decrypt a single 16 byte block in place.
+			void transform(std::uint8_t * block, bool encrypt) const;
+		};
+	}
+}
@@ -0,0 +1,258 @@
+//
+//  ConnectionIDTable.hpp
+//  This file is part of the "Protocol::QUIC" project and released under the MIT License.
+//
+//  Created by Samuel Williams on 16/10/2026.
+//  Copyright, 2026, by Samuel Williams. All rights reserved.
+//
+
+#pragma once
+
+#include "Connection.hpp"
+#include "Random.hpp"
+#include "SipHash.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+#include <ngtcp2/ngtcp2.h>
+
+namespace Protocol
+{
+	namespace QUIC
+	{
+		// A connection ID stored inline, so that it can be used as a key without allocating. Unused bytes are zero.
+		struct ConnectionID {
+			std::array<Byte, NGTCP2_MAX_CIDLEN> data = {};
+			std::uint8_t length = 0;
+			
+			ConnectionID() {}
+			
+			ConnectionID(const Byte * data, std::size_t length) : length(length)
+			{
+				std::memcpy(this->data.data(), data, length);
+			}
+			
+			ConnectionID(const ngtcp2_cid * cid) : ConnectionID(cid->data, cid->datalen) {}
+			
+			bool operator==(const ConnectionID & other) const noexcept
+			{
+				return length == other.length && std::memcmp(data.data(), other.data.data(), length) == 0;
+			}
+		};
+		
+		// The ConnectionIDTable class maps connection IDs to values (e.g. the server which owns the connection). It is an open addressing hash table with linear probing, so a lookup is a hash and a scan of adjacent slots, and allocates nothing. The hash is keyed with a secret generated per table (see `SipHash`), so that peers can't choose connection IDs which collide. Lookups of `LENGTH` byte connection IDs (the length we generate) are specialised at compile time.
+		template <typename Value, std::size_t LENGTH = DEFAULT_SCID_LENGTH>
+		class ConnectionIDTable
+		{
+		public:
+			static constexpr std::size_t DEFAULT_CAPACITY = 64;
+			
+			struct Slot {
+				ConnectionID key;
+				bool used = false;
+				Value value = {};
+			};
+			
+			class Iterator
+			{
+			public:
+				Iterator(Slot * slot, Slot * end) : _slot(slot), _end(end) {skip();}
+				
+				Slot & operator*() const noexcept {return *_slot;}
+				Slot * operator->() const noexcept {return _slot;}
+				
+				Iterator & operator++() noexcept {++_slot; skip(); return *this;}
+				
+				bool operator==(const Iterator & other) const noexcept {return _slot == other._slot;}
+				bool operator!=(const Iterator & other) const noexcept {return _slot != other._slot;}
+				
+			private:
+				Slot * _slot;
+				Slot * _end;
+				
+				void skip() noexcept {while (_slot != _end && !_slot->used) ++_slot;}
+			};
+			
+			// @parameter capacity the initial number of slots, rounded up to a power of two.
+			ConnectionIDTable(std::size_t capacity = DEFAULT_CAPACITY) : _slots(round_up(capacity)), _mask(_slots.size() - 1)
+			{
+				Random::generate_secure(reinterpret_cast<std::uint8_t *>(&_hash.k0), sizeof(_hash.k0));
+				Random::generate_secure(reinterpret_cast<std::uint8_t *>(&_hash.k1), sizeof(_hash.k1));
+			}
+			
+			ConnectionIDTable(const ConnectionIDTable &) = delete;
+			ConnectionIDTable & operator=(const ConnectionIDTable &) = delete;
+			
+			std::size_t size() const noexcept {return _size;}
+			bool empty() const noexcept {return _size == 0;}
+			
+			// The number of slots. The table grows when it is three quarters full.
+			std::size_t capacity() const noexcept {return _slots.size();}
+			
+			Iterator begin() noexcept {return Iterator(_slots.data(), _slots.data() + _slots.size());}
+			Iterator end() noexcept {return Iterator(_slots.data() + _slots.size(), _slots.data() + _slots.size());}
+			
+			std::uint64_t hash(const Byte * data, std::size_t length) const noexcept
+			{
+				if (length == LENGTH) return _hash.template hash<LENGTH>(data);
+				
+				return _hash(data, length);
+			}
+			
+			// Ensure that the given number of entries can be inserted without growing the table.
+			void reserve(std::size_t count)
+			{
+				auto capacity = round_up(count + count / 3 + 1);
+				
+				if (capacity > _slots.size()) {
+					resize(capacity);
+				}
+			}
+			
+			// Associate a connection ID with a value, if it is not already associated.
+			// @returns whether the value was inserted.
+			bool insert(const ConnectionID & key, Value value)
+			{
+				if ((_size + 1) * 4 > _slots.size() * 3) {
+					resize(_slots.size() * 2);
+				}
+				
+				auto index = locate(key.data.data(), key.length, hash(key.data.data(), key.length));
+				auto & slot = _slots[index];
+				
+				if (slot.used) return false;
+				
+				slot.key = key;
+				slot.used = true;
+				slot.value = value;
+				_size += 1;
+				
+				return true;
+			}
+			
+			// @returns a pointer to the value associated with the connection ID, or nullptr.
+			Value * find(const Byte * data, std::size_t length) noexcept
+			{
+				return find(data, length, hash(data, length));
+			}
+			
+			// Find a connection ID using a hash computed earlier by `hash`, e.g. when prefetching.
+			Value * find(const Byte * data, std::size_t length, std::uint64_t hash) noexcept
+			{
+				auto & slot = _slots[locate(data, length, hash)];
+				
+				return slot.used ? &slot.value : nullptr;
+			}
+			
+			// Hint that the slots for the given hash will be read soon, so that the cache miss can overlap with other work.
+			void prefetch(std::uint64_t hash) const noexcept
+			{
+				__builtin_prefetch(&_slots[hash & _mask]);
+			}
+			
+			Value * find(const ngtcp2_cid * cid) noexcept
+			{
+				return find(cid->data, cid->datalen);
+			}
+			
+			// Remove the connection ID, moving any following entries back so that no tombstones are left behind.
+			// @returns whether the connection ID was present.
+			bool erase(const Byte * data, std::size_t length) noexcept
+			{
+				auto index = locate(data, length, hash(data, length));
+				if (!_slots[index].used) return false;
+				
+				auto next = (index + 1) & _mask;
+				
+				while (_slots[next].used) {
+					auto & key = _slots[next].key;
+					auto home = hash(key.data.data(), key.length) & _mask;
+					
+					// If the entry's home slot isn't between the hole and the entry, it can move back into the hole:
+					if (((next - home) & _mask) >= ((next - index) & _mask)) {
+						_slots[index] = _slots[next];
+						index = next;
+					}
+					
+					next = (next + 1) & _mask;
+				}
+				
+				_slots[index] = Slot();
+				_size -= 1;
+				
+				return true;
+			}
+			
+			bool erase(const ngtcp2_cid * cid) noexcept
+			{
+				return erase(cid->data, cid->datalen);
+			}
+			
+			void clear() noexcept
+			{
+				std::fill(_slots.begin(), _slots.end(), Slot());
+				_size = 0;
+			}
+			
+		private:
+			std::vector<Slot> _slots;
+			std::size_t _mask;
+			std::size_t _size = 0;
+			
+			SipHash _hash;
+			
+			static std::size_t round_up(std::size_t capacity) noexcept
+			{
+				std::size_t size = 1;
+				
+				while (size < capacity) size <<= 1;
+				
+				return size;
+			}
+			
+			// @returns the index of the slot containing the connection ID, or the empty slot where it would be inserted.
+			std::size_t locate(const Byte * data, std::size_t length, std::uint64_t hash) const noexcept
+			{
+				if (length == LENGTH) return probe<LENGTH>(data, length, hash);
+				
+				return probe<0>(data, length, hash);
+			}
+			
+			// Compare keys using a length known at compile time, if `SIZE` is non-zero.
+			template <std::size_t SIZE>
+			std::size_t probe(const Byte * data, std::size_t length, std::uint64_t hash) const noexcept
+			{
+				auto index = hash & _mask;
+				
+				while (true) {
+					auto & slot = _slots[index];
+					
+					if (!slot.used) return index;
+					
+					if (slot.key.length == length && std::memcmp(slot.key.data.data(), data, SIZE ? SIZE : length) == 0) {
+						return index;
+					}
+					
+					index = (index + 1) & _mask;
+				}
+			}
+			
+			void resize(std::size_t capacity)
+			{
+				std::vector<Slot> slots(capacity);
+				std::swap(_slots, slots);
+				_mask = capacity - 1;
+				
+				for (auto & slot : slots) {
+					if (slot.used) {
+						_slots[probe<0>(slot.key.data.data(), slot.key.length, hash(slot.key.data.data(), slot.key.length))] = slot;
+					}
+				}
+			}
+		};
+	}
+}
@@ -8,8 +8,14 @@
 
 #include "Dispatcher.hpp"
 #include "Server.hpp"
+#include "Configuration.hpp"
+#include "Defer.hpp"
 
+#include <ngtcp2/ngtcp2_crypto.h>
+
+#include <algorithm>
 #include <array>
+#include <cassert>
 #include <ngtcp2/ngtcp2.h>
 #include <stdexcept>
 #include <iostream>
@@ -21,6 +27,9 @@ namespace Protocol
 	{
 		Dispatcher::Dispatcher(Configuration & configuration, TLS::ServerContext & tls_context) : _configuration(configuration), _tls_context(tls_context)
 		{
+			if (configuration.rate_limit > 0) {
+				_rate_limiter = std::make_unique<RateLimiter>(configuration.rate_limit, configuration.rate_limit_burst, RateLimiter::DEFAULT_CAPACITY, configuration.rate_limit_ipv4_prefix_length, configuration.rate_limit_ipv6_prefix_length);
+			}
 		}
 		
 		Dispatcher::~Dispatcher()
@@ -30,24 +39,49 @@ namespace Protocol
 		void Dispatcher::close()
 		{
 			while (!_servers.empty()) {
-				auto server = _servers.begin()->second;
+				auto server = _servers.begin()->value;
 				server->close();
 			}
 		}
 		
-		std::string cid_key(const Byte * cid, std::size_t length)
+		void Dispatcher::set_worker(std::size_t worker, std::size_t workers)
+		{
+			assert(worker < workers && workers <= 256);
+			
+			// Fail when the server is set up, rather than when the first connection ID is generated:
+			if (auto & generator = _configuration.connection_id_generator) {
+				if (workers > generator->maximum_workers()) {
+					throw std::invalid_argument("Connection IDs can't be routed to this many workers!");
+				}
+			}
+			
+			_worker = worker;
+			_workers = workers;
+		}
+		
+		Server * Dispatcher::create_server(Socket &socket, const Address &local_address, const Address &remote_address, const ngtcp2_pkt_hd &packet_header, ngtcp2_cid *ocid)
+		{
+			_retry_unsupported = true;
+			
+			// The original overload can't pass on the original destination connection ID, so the handshake would fail:
+			if (ocid) return nullptr;
+			
+			return create_server(socket, remote_address, packet_header);
+		}
+		
+		Server * Dispatcher::create_server(Socket &socket, const Address &address, const ngtcp2_pkt_hd &packet_header)
 		{
-			return std::string(reinterpret_cast<const char *>(cid), length);
+			throw std::logic_error("Dispatcher sub-classes must implement create_server!");
 		}
 		
 		void Dispatcher::associate(const ngtcp2_cid *cid, Server * server)
 		{
-			_servers.emplace(cid_key(cid->data, cid->datalen), server);
+			_servers.insert(cid, server);
 		}
 		
 		void Dispatcher::disassociate(const ngtcp2_cid *cid)
 		{
-			_servers.erase(cid_key(cid->data, cid->datalen));
+			_servers.erase(cid);
 		}
 		
 		void Dispatcher::remove(Server * server)
@@ -58,51 +92,335 @@ namespace Protocol
 			for (auto & scid : scids) {
 				disassociate(&scid);
 			}
+			
+			auto redirected = std::find(_redirected.begin(), _redirected.end(), server);
+			if (redirected != _redirected.end()) {
+				_redirected.erase(redirected);
+			}
+			
+			if (server->_waiting_writable) {
+				_waiting_writable.erase(std::find(_waiting_writable.begin(), _waiting_writable.end(), server));
+				server->_waiting_writable = false;
+			}
 		}
 		
 		void Dispatcher::send_packets()
 		{
-			for (auto & server : _servers) {
-				server.second->send_packets();
+			// Each server has a slot for each of its connection IDs, but should only be asked to send once:
+			_scratch.clear();
+			
+			for (auto & slot : _servers) {
+				_scratch.push_back(slot.value);
+			}
+			
+			std::sort(_scratch.begin(), _scratch.end());
+			_scratch.erase(std::unique(_scratch.begin(), _scratch.end()), _scratch.end());
+			
+			for (auto server : _scratch) {
+				server->send_packets();
+			}
+		}
+		
+		void Dispatcher::wait_writable(Server * server)
+		{
+			if (!server->_waiting_writable) {
+				server->_waiting_writable = true;
+				_waiting_writable.push_back(server);
 			}
 		}
 		
-		Server* Dispatcher::listen(Socket &socket)
+		void Dispatcher::resume_writable(Socket & socket)
 		{
-			Address remote_address;
-			ECN ecn = ECN::UNSPECIFIED;
-			std::array<Byte, 1024*64> buffer;
+			// Try to send the queued packets without waiting, and leave the servers waiting if the socket is still backlogged:
+			if (_waiting_writable.empty() || socket.backlogged()) return;
+			
+			_scratch.swap(_waiting_writable);
+			
+			for (auto server : _scratch) {
+				server->_waiting_writable = false;
+			}
+			
+			for (auto server : _scratch) {
+				server->send_packets();
+				
+				if (server->backlogged()) {
+					wait_writable(server);
+				}
+			}
+			
+			_scratch.clear();
+		}
+		
+		std::optional<Timestamp> Dispatcher::writable_timeout() const
+		{
+			if (_waiting_writable.empty()) return std::nullopt;
+			
+			return Timestamp(Timestamp::from_nanoseconds(timestamp() + WRITABLE_INTERVAL));
+		}
+		
+		void Dispatcher::check_socket(const Socket & socket) const
+		{
+			if (_configuration.connected_sockets && socket.reuse_port_steering()) {
+				throw std::invalid_argument("Connected sockets prevent the kernel from steering packets!");
+			}
+		}
+		
+		Server * Dispatcher::take_redirected()
+		{
+			if (_redirected.empty()) return nullptr;
+			
+			auto server = _redirected.back();
+			_redirected.pop_back();
+			
+			return server;
+		}
+		
+		Server* Dispatcher::listen(Socket &socket, ReceiveBatch &batch)
+		{
+			check_socket(socket);
 			
 			while (socket) {
-				auto length = socket.receive_packet(buffer.data(), buffer.size(), remote_address, ecn);
+				if (auto server = take_redirected()) {
+					return server;
+				}
+				
+				Server * server = nullptr;
 				
-				ngtcp2_version_cid version_cid;
-				auto result = ngtcp2_pkt_decode_version_cid(&version_cid, buffer.data(), length, DEFAULT_SCID_LENGTH);
+				// Packets produced by all servers while processing the batch are sent together:
+				socket.hold();
 				
-				if (result == 0) {
-					auto server = process_packet(socket, remote_address, buffer.data(), length, ecn, version_cid);
+				try {
+					if (_header_offset >= _headers.size()) {
+						classify(batch);
+					}
 					
-					if (server) {
-						return server;
+					// Drain the current batch before going back to the socket:
+					while (!server && _header_offset < _headers.size()) {
+						auto & header = _headers[_header_offset++];
+						
+						server = dispatch(socket, header);
 					}
+				} catch (...) {
+					socket.flush();
+					throw;
 				}
-				else if (result == NGTCP2_ERR_VERSION_NEGOTIATION) {
-					send_version_negotiation(socket, version_cid, remote_address);
+				
+				socket.flush();
+				
+				// Servers stop writing packets while the socket is backlogged, so once it has caught up they can continue:
+				resume_writable(socket);
+				
+				if (server) {
+					return server;
 				}
-				else {
-					std::cerr << "listen: " << ngtcp2_strerror(result) << std::endl;
+				
+				// While servers are waiting to write, don't wait for packets indefinitely:
+				auto timeout = writable_timeout();
+				socket.receive_packets(batch, extract_optional(timeout));
+			}
+			
+			return nullptr;
+		}
+		
+		Server* Dispatcher::listen(Socket & socket)
+		{
+			if (!_batch) {
+				_batch = std::make_unique<ReceiveBatch>();
+			}
+			
+			return listen(socket, *_batch);
+		}
+		
+		Server* Dispatcher::listen(Socket & socket, PacketQueue & queue)
+		{
+			check_socket(socket);
+			
+			// Otherwise, every packet larger than a slot would be dropped, including path MTU probes, so larger payloads could never be confirmed:
+			if (queue.packet_size() < _configuration.max_tx_udp_payload_size) {
+				throw std::invalid_argument("Packet queue is too small for the maximum UDP payload size!");
+			}
+			
+			while (socket) {
+				if (auto server = take_redirected()) {
+					return server;
+				}
+				
+				Server * server = nullptr;
+				
+				socket.hold();
+				
+				try {
+					while (!server) {
+						auto packet = queue.front();
+						if (!packet) break;
+						
+						// The packet is released once it has been processed, as ngtcp2 reads it in place:
+						auto release = defer([&]{queue.pop();});
+						
+						server = dispatch_packet(socket, packet->local_address, packet->remote_address, packet->data, packet->size, packet->ecn, packet->receive_time);
+					}
+				} catch (...) {
+					socket.flush();
+					throw;
+				}
+				
+				socket.flush();
+				
+				resume_writable(socket);
+				
+				if (server) {
+					return server;
 				}
+				
+				auto timeout = writable_timeout();
+				queue.wait(extract_optional(timeout));
 			}
 			
 			return nullptr;
 		}
 		
+		int Dispatcher::decode_header(ngtcp2_version_cid & version_cid, const Byte * data, std::size_t length, std::size_t cid_length)
+		{
+			// Short header packets have the most significant bit cleared, and only contain the destination connection ID, immediately after the first byte:
+			if (length > 0 && (data[0] & 0x80) == 0) {
+				if (length < 1 + cid_length) return NGTCP2_ERR_INVALID_ARGUMENT;
+				
+				version_cid = ngtcp2_version_cid{};
+				version_cid.dcid = data + 1;
+				version_cid.dcidlen = cid_length;
+				
+				return 0;
+			}
+			
+			return ngtcp2_pkt_decode_version_cid(&version_cid, data, length, cid_length);
+		}
+		
+		std::size_t Dispatcher::connection_id_length() const noexcept
+		{
+			if (auto & generator = _configuration.connection_id_generator) {
+				return generator->length();
+			}
+			
+			return DEFAULT_SCID_LENGTH;
+		}
+		
+		void Dispatcher::classify(ReceiveBatch & batch)
+		{
+			_headers.clear();
+			_header_offset = 0;
+			
+			auto cid_length = connection_id_length();
+			
+			while (auto packet = batch.next()) {
+				_headers.emplace_back();
+				auto & header = _headers.back();
+				
+				header.local_address = &packet->local_address;
+				header.remote_address = &packet->remote_address;
+				header.data = packet->data;
+				header.size = packet->size;
+				header.ecn = packet->ecn;
+				header.receive_time = packet->receive_time;
+				
+				header.result = decode_header(header.version_cid, header.data, header.size, cid_length);
+				
+				if (header.result == 0) {
+					header.hash = _servers.hash(header.version_cid.dcid, header.version_cid.dcidlen);
+					_servers.prefetch(header.hash);
+				}
+			}
+			
+			for (auto & header : _headers) {
+				if (header.result == 0) {
+					if (auto server = _servers.find(header.version_cid.dcid, header.version_cid.dcidlen, header.hash)) {
+						__builtin_prefetch(*server);
+					}
+				}
+			}
+		}
+		
+		Server* Dispatcher::dispatch_packet(Socket &socket, const Address &local_address, const Address &remote_address, const Byte * data, std::size_t length, ECN ecn, std::uint64_t receive_time)
+		{
+			Header header;
+			header.local_address = &local_address;
+			header.remote_address = &remote_address;
+			header.data = data;
+			header.size = length;
+			header.ecn = ecn;
+			header.receive_time = receive_time;
+			
+			header.result = decode_header(header.version_cid, data, length, connection_id_length());
+			
+			if (header.result == 0) {
+				header.hash = _servers.hash(header.version_cid.dcid, header.version_cid.dcidlen);
+			}
+			
+			return dispatch(socket, header);
+		}
+		
+		void Dispatcher::redirect_packet(Socket &socket, const Address &local_address, const Address &remote_address, const Byte * data, std::size_t length, ECN ecn, std::uint64_t receive_time)
+		{
+			if (auto server = dispatch_packet(socket, local_address, remote_address, data, length, ecn, receive_time)) {
+				_redirected.push_back(server);
+			}
+		}
+		
+		Server* Dispatcher::dispatch(Socket & socket, const Header & header)
+		{
+			if (header.result == 0) {
+				return process_packet(socket, header);
+			}
+			else if (header.result == NGTCP2_ERR_VERSION_NEGOTIATION) {
+				// Packets smaller than the minimum Initial packet size can't start a connection, and are dropped to limit amplification (RFC 9000 §14.1):
+				if (header.size >= NGTCP2_MAX_UDP_PAYLOAD_SIZE) {
+					auto version_cid = header.version_cid;
+					send_version_negotiation(socket, version_cid, *header.local_address, *header.remote_address);
+				}
+			}
+			else {
+				std::cerr << "listen: " << ngtcp2_strerror(header.result) << std::endl;
+			}
+			
+			return nullptr;
+		}
+		
+		Server* Dispatcher::process_packet(Socket & socket, const Address &local_address, const Address &remote_address, const Byte * data, std::size_t length, ECN ecn, std::uint64_t receive_time, ngtcp2_version_cid &version_cid)
+		{
+			Header header;
+			header.local_address = &local_address;
+			header.remote_address = &remote_address;
+			header.data = data;
+			header.size = length;
+			header.ecn = ecn;
+			header.receive_time = receive_time;
+			header.version_cid = version_cid;
+			header.hash = _servers.hash(version_cid.dcid, version_cid.dcidlen);
+			
+			return process_packet(socket, header);
+		}
+		
 		Server* Dispatcher::process_packet(Socket & socket, const Address &remote_address, const Byte * data, std::size_t length, ECN ecn, ngtcp2_version_cid &version_cid)
 		{
-			auto dcid_key = cid_key(version_cid.dcid, version_cid.dcidlen);
-			auto iterator = _servers.find(dcid_key);
+			return process_packet(socket, socket.local_address(), remote_address, data, length, ecn, 0, version_cid);
+		}
+		
+		Server* Dispatcher::process_packet(Socket & socket, const Header & header)
+		{
+			auto & version_cid = header.version_cid;
+			auto & local_address = *header.local_address;
+			auto & remote_address = *header.remote_address;
+			auto data = header.data;
+			auto length = header.size;
 			
-			if (iterator == std::end(_servers)) {
+			auto entry = _servers.find(version_cid.dcid, version_cid.dcidlen, header.hash);
+			
+			if (!entry) {
+				// A short header packet for an unknown connection can't start a new one:
+				if ((data[0] & 0x80) == 0) {
+					send_stateless_reset(socket, local_address, remote_address, version_cid, length);
+					return nullptr;
+				}
+				
 				ngtcp2_pkt_hd packet_header;
 				// The incoming packet is for a new connection.
 				auto result = ngtcp2_accept(&packet_header, data, length);
@@ -112,14 +430,73 @@ namespace Protocol
 					return nullptr;
 				}
 				
-				// TODO: Stateless retry.
+				auto now = timestamp();
+				
+				ngtcp2_cid ocid;
+				ngtcp2_cid * retried = nullptr;
+				bool validated = false;
 				
-				auto server = this->create_server(socket, remote_address, packet_header);
-				server->process_packet(socket, remote_address, data, length, ecn);
+				auto & secret = _configuration.static_secret;
+				
+				if (packet_header.tokenlen > 0 && packet_header.token[0] == NGTCP2_CRYPTO_TOKEN_MAGIC_RETRY) {
+					// The token binds the client's address to the connection ID it was sent to, and recovers the original destination connection ID:
+					if (ngtcp2_crypto_verify_retry_token(&ocid, packet_header.token, packet_header.tokenlen, secret.data(), secret.size(), packet_header.version, &remote_address.data.sa, remote_address.length, &packet_header.dcid, _configuration.retry_token_timeout, now) != 0) {
+						send_connection_close(socket, local_address, remote_address, packet_header, NGTCP2_INVALID_TOKEN);
+						return nullptr;
+					}
+					
+					retried = &ocid;
+					validated = true;
+				}
+				else if (packet_header.tokenlen > 0 && packet_header.token[0] == NGTCP2_CRYPTO_TOKEN_MAGIC_REGULAR) {
+					// A token issued by `Server::submit_new_token` during a previous connection from the same address. Invalid tokens (e.g. expired, or from another server) are ignored, as if the client had sent none (RFC 9000 §8.1.3):
+					validated = ngtcp2_crypto_verify_regular_token(packet_header.token, packet_header.tokenlen, secret.data(), secret.size(), &remote_address.data.sa, remote_address.length, _configuration.new_token_timeout, now) == 0;
+				}
+				
+				if (!validated) {
+					auto retry = retry_required(now);
+					
+					// Only new connections from unvalidated addresses are limited, before any work is done for them. A client answering a Retry packet has already been counted:
+					if (_rate_limiter && !_rate_limiter->allow(remote_address, now)) {
+						switch (_configuration.rate_limit_action) {
+							case Configuration::RateLimitAction::DROP:
+								return nullptr;
+							case Configuration::RateLimitAction::REFUSE:
+								send_connection_close(socket, local_address, remote_address, packet_header, NGTCP2_CONNECTION_REFUSED);
+								return nullptr;
+							case Configuration::RateLimitAction::RETRY:
+								if (_retry_unsupported) return nullptr;
+								retry = true;
+								break;
+						}
+					}
+					
+					if (retry) {
+						// 0-RTT packets can't be answered with a Retry packet, and are dropped; the client's Initial packet will be:
+						if (packet_header.type == NGTCP2_PKT_INITIAL) {
+							send_retry(socket, local_address, remote_address, packet_header);
+						}
+						
+						return nullptr;
+					}
+					
+					// ngtcp2 treats the address of a connection created with a token as validated:
+					packet_header.token = nullptr;
+					packet_header.tokenlen = 0;
+				}
+				
+				auto server = this->create_server(socket, local_address, remote_address, packet_header, retried);
+				if (!server) return nullptr;
+				
+				server->process_packet(socket, local_address, remote_address, data, length, header.ecn, header.receive_time);
 				server->send_packets();
 				
+				if (server->backlogged()) {
+					wait_writable(server);
+				}
+				
 				// Associate all the connection IDs with the server:
-				_servers.emplace(dcid_key, server);
+				_servers.insert(ConnectionID(version_cid.dcid, version_cid.dcidlen), server);
 				
 				auto scids = server->scids();
 				for (auto & scid : scids) {
@@ -129,16 +506,167 @@ namespace Protocol
 				return server;
 			}
 			else {
-				auto server = iterator->second;
-				server->process_packet(socket, remote_address, data, length, ecn);
+				auto server = *entry;
+				server->process_packet(socket, local_address, remote_address, data, length, header.ecn, header.receive_time);
 				server->send_packets();
+				
+				if (server->backlogged()) {
+					wait_writable(server);
+				}
 				return nullptr;
 			}
 		}
 		
-		void Dispatcher::send_version_negotiation(Socket & socket, ngtcp2_version_cid &version_cid, const Address &address)
+		bool Dispatcher::retry_required(std::uint64_t now)
+		{
+			if (_retry_unsupported) return false;
+			
+			switch (_configuration.retry) {
+				case Configuration::Retry::NEVER:
+					return false;
+				case Configuration::Retry::ALWAYS:
+					return true;
+				case Configuration::Retry::AUTOMATIC:
+					break;
+			}
+			
+			// Measure the rate of attempts over one second windows, and keep retrying for the whole of the next window once the rate has been exceeded, so that the decision doesn't flap while under attack:
+			if (now - _attempts_window >= NGTCP2_SECONDS) {
+				_retrying = _attempts > _configuration.retry_threshold;
+				_attempts_window = now;
+				_attempts = 0;
+			}
+			
+			_attempts += 1;
+			
+			if (_attempts > _configuration.retry_threshold) {
+				_retrying = true;
+			}
+			
+			return _retrying;
+		}
+		
+		void Dispatcher::send_retry(Socket & socket, const Address &local_address, const Address &remote_address, const ngtcp2_pkt_hd &packet_header)
+		{
+			// The connection ID the client will use for its next Initial packet, which routes it back to this worker:
+			ngtcp2_cid scid;
+			
+			if (auto & generator = _configuration.connection_id_generator) {
+				generator->generate(&scid, _worker, _workers);
+			} else {
+				// The same as `Connection::generate_cid`, which servers use without a generator:
+				Random::generate_secure(scid.data, DEFAULT_SCID_LENGTH);
+				scid.datalen = DEFAULT_SCID_LENGTH;
+				
+				// Encode the worker in the first byte, as the default `ConnectionIDGenerator` does, which is where a `Distributor` looks for it by default:
+				if (_workers > 1) {
+					scid.data[0] = _worker;
+				}
+			}
+			
+			auto & secret = _configuration.static_secret;
+			std::array<Byte, NGTCP2_CRYPTO_MAX_RETRY_TOKENLEN> token;
+			
+			auto token_length = ngtcp2_crypto_generate_retry_token(token.data(), secret.data(), secret.size(), packet_header.version, &remote_address.data.sa, remote_address.length, &scid, &packet_header.dcid, timestamp());
+			
+			if (token_length < 0) {
+				std::cerr << "send_retry: failed to generate retry token" << std::endl;
+				return;
+			}
+			
+			std::array<Byte, NGTCP2_MAX_UDP_PAYLOAD_SIZE> buffer;
+			
+			auto size = ngtcp2_crypto_write_retry(buffer.data(), buffer.size(), packet_header.version, &packet_header.scid, &scid, &packet_header.dcid, token.data(), token_length);
+			
+			if (size < 0) {
+				std::cerr << "send_retry: " << ngtcp2_strerror(size) << std::endl;
+				return;
+			}
+			
+			const Destination source = local_address;
+			socket.send_packet(buffer.data(), size, remote_address, ECN::UNSPECIFIED, nullptr, 0, 0, &source);
+		}
+		
+		void Dispatcher::send_connection_close(Socket & socket, const Address &local_address, const Address &remote_address, const ngtcp2_pkt_hd &packet_header, std::uint64_t error_code)
+		{
+			std::array<Byte, NGTCP2_MAX_UDP_PAYLOAD_SIZE> buffer;
+			
+			auto size = ngtcp2_crypto_write_connection_close(buffer.data(), buffer.size(), packet_header.version, &packet_header.scid, &packet_header.dcid, error_code, nullptr, 0);
+			
+			if (size < 0) {
+				std::cerr << "send_connection_close: " << ngtcp2_strerror(size) << std::endl;
+				return;
+			}
+			
+			const Destination source = local_address;
+			socket.send_packet(buffer.data(), size, remote_address, ECN::UNSPECIFIED, nullptr, 0, 0, &source);
+		}
+		
+		void Dispatcher::send_version_negotiation(Socket & socket, ngtcp2_version_cid &version_cid, const Address &local_address, const Address &remote_address)
+		{
+			static const std::array<std::uint32_t, 2> supported_versions = {NGTCP2_PROTO_VER_V1, NGTCP2_PROTO_VER_V2};
+			
+			std::array<Byte, NGTCP2_MAX_UDP_PAYLOAD_SIZE> buffer;
+			std::uint8_t unused_random;
+			_random.generate(&unused_random, sizeof(unused_random));
+			
+			// The connection IDs are echoed back to the client, swapped:
+			auto size = ngtcp2_pkt_write_version_negotiation(buffer.data(), buffer.size(), unused_random, version_cid.scid, version_cid.scidlen, version_cid.dcid, version_cid.dcidlen, supported_versions.data(), supported_versions.size());
+			
+			if (size < 0) {
+				std::cerr << "send_version_negotiation: " << ngtcp2_strerror(size) << std::endl;
+				return;
+			}
+			
+			const Destination source = local_address;
+			socket.send_packet(buffer.data(), size, remote_address, ECN::UNSPECIFIED, nullptr, 0, 0, &source);
+		}
+		
+		void Dispatcher::send_stateless_reset(Socket & socket, const Address &local_address, const Address &remote_address, const ngtcp2_version_cid &version_cid, std::size_t length)
 		{
-			// std::array<Byte, NGTCP2_MAX_UDP_PAYLOAD_SIZE> buffer;
+			auto rate = _configuration.stateless_reset_rate;
+			if (rate == 0) return;
+			
+			// The reset must be smaller than the packet, but still contain enough unpredictable bytes to look like a short header packet:
+			constexpr std::size_t MINIMUM_LENGTH = NGTCP2_MIN_STATELESS_RESET_RANDLEN + NGTCP2_STATELESS_RESET_TOKENLEN;
+			constexpr std::size_t MAXIMUM_LENGTH = NGTCP2_MAX_CIDLEN + 22;
+			
+			if (length <= MINIMUM_LENGTH) return;
+			
+			// Refill the token bucket, allowing a burst of up to one second's worth of resets:
+			auto now = timestamp();
+			_stateless_resets = std::min<double>(rate, _stateless_resets + static_cast<double>(now - _stateless_resets_time) * rate / NGTCP2_SECONDS);
+			_stateless_resets_time = now;
+			
+			if (_stateless_resets < 1) return;
+			_stateless_resets -= 1;
+			
+			auto cid = ngtcp2_cid{};
+			ngtcp2_cid_init(&cid, version_cid.dcid, version_cid.dcidlen);
+			
+			auto & static_secret = _configuration.static_secret;
+			std::array<std::uint8_t, NGTCP2_STATELESS_RESET_TOKENLEN> token;
+			
+			if (ngtcp2_crypto_generate_stateless_reset_token(token.data(), static_secret.data(), static_secret.size(), &cid) != 0) {
+				std::cerr << "send_stateless_reset: failed to generate stateless reset token" << std::endl;
+				return;
+			}
+			
+			std::array<std::uint8_t, MAXIMUM_LENGTH - NGTCP2_STATELESS_RESET_TOKENLEN> random;
+			auto random_length = std::min(length - 1, MAXIMUM_LENGTH) - NGTCP2_STATELESS_RESET_TOKENLEN;
+			_random.generate(random.data(), random_length);
+			
+			std::array<Byte, MAXIMUM_LENGTH> buffer;
+			
+			auto size = ngtcp2_pkt_write_stateless_reset(buffer.data(), buffer.size(), token.data(), random.data(), random_length);
+			
+			if (size < 0) {
+				std::cerr << "send_stateless_reset: " << ngtcp2_strerror(size) << std::endl;
+				return;
+			}
+			
+			const Destination source = local_address;
+			socket.send_packet(buffer.data(), size, remote_address, ECN::UNSPECIFIED, nullptr, 0, 0, &source);
 		}
 	}
 }
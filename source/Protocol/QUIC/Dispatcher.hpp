@@ -11,9 +11,13 @@
 #include "TLS/ServerContext.hpp"
 #include "Server.hpp"
 #include "Socket.hpp"
+#include "ReceiveBatch.hpp"
+#include "PacketQueue.hpp"
+#include "ConnectionIDTable.hpp"
+#include "Random.hpp"
+#include "RateLimiter.hpp"
 #include "ngtcp2/ngtcp2.h"
 
-#include <unordered_map>
 #include <memory>
 
 namespace Protocol
@@ -35,31 +39,164 @@ namespace Protocol
 			const Configuration & configuration() const noexcept {return _configuration;}
 			const TLS::ServerContext & tls_context() const noexcept {return _tls_context;}
 			
+			// In a sharded server, the index of the worker which owns this dispatcher's connections, see `Distributor`. Servers encode it in the connection IDs they generate. Throws `std::invalid_argument` if the configured generator can't route connections to this many workers.
+			void set_worker(std::size_t worker, std::size_t workers);
+			std::size_t worker() const noexcept {return _worker;}
+			std::size_t workers() const noexcept {return _workers;}
+			
 			void associate(const ngtcp2_cid *cid, Server * server);
 			void disassociate(const ngtcp2_cid *cid);
 			
 			virtual void remove(Server * server);
 			
-			// Create a server instance to handle a new connection.
-			virtual Server * create_server(Socket &socket, const Address &address, const ngtcp2_pkt_hd &packet_header) = 0;
+			// Create a server instance to handle a new connection. By default, this uses the original overload below, unless the client was validated by a Retry packet.
+			// @parameter local_address the address the connection was received on, see `ReceiveBatch::Packet::local_address`.
+			// @parameter ocid the original destination connection ID, if the client's address was validated by a Retry packet, which must be passed to the `Server` constructor.
+			// @returns the server, or null to ignore the packet.
+			virtual Server * create_server(Socket &socket, const Address &local_address, const Address &remote_address, const ngtcp2_pkt_hd &packet_header, ngtcp2_cid *ocid = nullptr);
+			
+			// Create a server instance to handle a new connection, using the socket's local address. Sub-classes which only override this overload can't accept connections validated by a Retry packet, so once it's used, the dispatcher stops sending them.
+			virtual Server * create_server(Socket &socket, const Address &address, const ngtcp2_pkt_hd &packet_header);
+			
+			// Whether new connections must currently validate their address with a Retry packet, see `Configuration::retry`.
+			bool retrying() const noexcept {return _retrying;}
 			
-			// Wait for incoming connections and create servers to handle them.
+			// Wait for incoming connections and create servers to handle them. Connected sockets (`Configuration::connected_sockets`) can't be used with `Socket::set_reuse_port_steering`, and are rejected by throwing `std::invalid_argument`. Packets are received in batches, and the entire batch is processed before waiting on the socket again. Each batch is first classified in a single pass (see `classify`), which prefetches the routing table entries and servers, before any packets are processed. If a new server is created, it is returned immediately and the remainder of the batch is processed on the next call, so a dispatcher should only listen on one batch at a time. Packets sent by servers while processing a batch are held and flushed together using `Socket::hold` and `Socket::flush`. Latency-sensitive listeners can enable `Socket::set_busy_poll` to avoid waiting for readiness while packets are arriving continuously.
+			Server* listen(Socket & socket, ReceiveBatch & batch);
+			
+			// Wait for incoming connections and create servers to handle them, receiving packets into a batch owned by the dispatcher, see `listen(Socket &, ReceiveBatch &)`.
 			Server* listen(Socket & socket);
 			
+			// Wait for packets handed to this worker by a `Distributor`, and process them in the same way as `listen(Socket &, ReceiveBatch &)`. The queue's packets must be large enough for `Configuration::max_tx_udp_payload_size`, otherwise `std::invalid_argument` is thrown.
+			// @parameter socket the socket used to send packets, usually a `Socket::duplicate` of the listening socket.
+			Server* listen(Socket & socket, PacketQueue & queue);
+			
+			// Decode and route a single incoming packet from a given remote address.
+			Server* dispatch_packet(Socket & socket, const Address &local_address, const Address &remote_address, const Byte * data, std::size_t length, ECN ecn, std::uint64_t receive_time = 0);
+			
+			// Route a packet which was received by a server's connected socket, but belongs to another connection, e.g. while the connected socket was joining the listening socket's `SO_REUSEPORT` group. If the packet creates a new server, it's returned by the next call to `listen`.
+			// @parameter socket the listening socket, which is used to reply.
+			void redirect_packet(Socket & socket, const Address &local_address, const Address &remote_address, const Byte * data, std::size_t length, ECN ecn, std::uint64_t receive_time = 0);
+			
 			// Process a single incoming packet from a given remote address.
+			Server* process_packet(Socket & socket, const Address &local_address, const Address &remote_address, const Byte * data, std::size_t length, ECN ecn, std::uint64_t receive_time, ngtcp2_version_cid &version_cid);
+			
+			// Process a single incoming packet received on the socket's bound address.
 			Server* process_packet(Socket & socket, const Address &remote_address, const Byte * data, std::size_t length, ECN ecn, ngtcp2_version_cid &version_cid);
 			
+			// Decode the version and connection IDs of a packet. Short header packets, which carry almost all the traffic, are decoded inline. Long header packets are decoded by `ngtcp2_pkt_decode_version_cid`.
+			// @parameter cid_length the length of our connection IDs, see `ConnectionIDGenerator::length`.
+			// @returns 0 on success, or an ngtcp2 error code, e.g. `NGTCP2_ERR_VERSION_NEGOTIATION`.
+			static int decode_header(ngtcp2_version_cid & version_cid, const Byte * data, std::size_t length, std::size_t cid_length = DEFAULT_SCID_LENGTH);
+			
+			// The length of the connection IDs generated by our servers.
+			std::size_t connection_id_length() const noexcept;
+			
+			// Ask every server to send any pending packets.
 			void send_packets();
 			
+			// Remember that a server stopped writing packets because the socket is backlogged, so that it can continue once the socket has caught up. Each server is only remembered once.
+			void wait_writable(Server * server);
+			
 		protected:
 			Configuration & _configuration;
 			TLS::ServerContext & _tls_context;
 			
-			void send_version_negotiation(Socket & socket, ngtcp2_version_cid &version_cid, const Address &remote_address);
+			// Tell the client which versions we support, in response to a packet with an unsupported version.
+			void send_version_negotiation(Socket & socket, ngtcp2_version_cid &version_cid, const Address &local_address, const Address &remote_address);
+			
+			// Reset a connection we don't know about (e.g. one lost in a restart) in response to a short header packet, so the client doesn't have to wait for its idle timeout. The reset token is derived from `Configuration::static_secret` and the destination connection ID, as it was when the connection ID was issued. The reset is smaller than the packet which triggered it, so that two endpoints can't reset each other in a loop, and is limited to `Configuration::stateless_reset_rate`.
+			void send_stateless_reset(Socket & socket, const Address &local_address, const Address &remote_address, const ngtcp2_version_cid &version_cid, std::size_t length);
+			
+			// Ask the client to validate its address by sending a Retry packet containing a token, without creating any connection state. The client repeats its Initial packet with the token, addressed to a new connection ID generated for this dispatcher's worker.
+			void send_retry(Socket & socket, const Address &local_address, const Address &remote_address, const ngtcp2_pkt_hd &packet_header);
+			
+			// Close the connection without creating any connection state, e.g. if the client's token is invalid.
+			void send_connection_close(Socket & socket, const Address &local_address, const Address &remote_address, const ngtcp2_pkt_hd &packet_header, std::uint64_t error_code);
+			
+			// Count a new connection attempt, and decide whether it must be validated with a Retry packet.
+			bool retry_required(std::uint64_t now);
+			
+			// A received packet, and its decoded header.
+			struct Header {
+				const Address * local_address = nullptr;
+				const Address * remote_address = nullptr;
+				
+				const Byte * data = nullptr;
+				std::size_t size = 0;
+				
+				ECN ecn = ECN::UNSPECIFIED;
+				std::uint64_t receive_time = 0;
+				
+				// The result of `decode_header`:
+				int result = 0;
+				ngtcp2_version_cid version_cid;
+				
+				// The hash of the destination connection ID in the routing table:
+				std::uint64_t hash = 0;
+			};
+			
+			// Throw `std::invalid_argument` if the socket can't be used with the configuration.
+			void check_socket(const Socket & socket) const;
+			
+			// The next server created by `redirect_packet` which hasn't been returned by `listen`, if any.
+			Server * take_redirected();
+			
+			// How often the dispatcher tries to send queued packets while servers are waiting to write, in nanoseconds.
+			static constexpr std::uint64_t WRITABLE_INTERVAL = 1000 * 1000;
+			
+			// If the socket has caught up, without waiting, let the servers waiting to write continue.
+			void resume_writable(Socket & socket);
+			
+			// The timeout for receiving packets, so that servers waiting to write aren't stalled until the next packet arrives.
+			std::optional<Timestamp> writable_timeout() const;
+			
+			// Consume all the packets in the batch and decode their headers, then prefetch the routing table slots, and once those have arrived, the servers which own the connections. By the time each packet is processed, the memory it needs is likely to be in the cache.
+			void classify(ReceiveBatch & batch);
+			
+			// Route a packet with a decoded header to the server which owns the connection, or create a new server.
+			Server* dispatch(Socket & socket, const Header & header);
+			
+			Server* process_packet(Socket & socket, const Header & header);
 			
 		private:
 			// Associates a connection ID with a server instance:
-			std::unordered_map<std::string, Server *> _servers;
+			ConnectionIDTable<Server *> _servers;
+			
+			std::size_t _worker = 0;
+			std::size_t _workers = 1;
+			
+			// The number of new connection attempts since the start of the current one second window, used by `Configuration::Retry::AUTOMATIC`:
+			std::uint64_t _attempts_window = 0;
+			std::size_t _attempts = 0;
+			bool _retrying = false;
+			
+			// Whether servers are created by the original `create_server` overload, which can't accept connections validated by a Retry packet:
+			bool _retry_unsupported = false;
+			
+			// A token bucket limiting the rate of stateless resets, refilled at `Configuration::stateless_reset_rate`:
+			double _stateless_resets = 0;
+			std::uint64_t _stateless_resets_time = 0;
+			
+			// Limits the rate of new connections from each source prefix, if enabled by `Configuration::rate_limit`:
+			std::unique_ptr<RateLimiter> _rate_limiter;
+			
+			// Used for the unpredictable bytes of stateless reset and version negotiation packets:
+			Random _random;
+			
+			// The classified packets of the current batch, and the next one to be processed:
+			std::vector<Header> _headers;
+			std::size_t _header_offset = 0;
+			
+			// Servers created by `redirect_packet`, which are returned by `listen`:
+			std::vector<Server *> _redirected;
+			
+			// Servers which stopped writing packets because the socket was backlogged:
+			std::vector<Server *> _waiting_writable;
+			std::vector<Server *> _scratch;
+			
+			// The batch used by `listen(Socket &)`, which must outlive the classified headers which refer to it:
+			std::unique_ptr<ReceiveBatch> _batch;
 		};
 	}
 }
@@ -0,0 +1,91 @@
+//
+//  Distributor.cpp
+//  This file is part of the "Protocol::QUIC" project and released under the MIT License.
+//
+//  Created by Samuel Williams on 16/10/2026.
+//  Copyright, 2026, by Samuel Williams. All rights reserved.
+//
+
+#include "Distributor.hpp"
+#include "Dispatcher.hpp"
+
+#include <algorithm>
+#include <cassert>
+#include <stdexcept>
+
+namespace Protocol
+{
+	namespace QUIC
+	{
+		Distributor::Distributor(std::size_t workers, std::size_t capacity, std::size_t packet_size) : _pending(workers)
+		{
+			assert(workers > 0 && workers <= 256);
+			
+			for (std::size_t index = 0; index < workers; index += 1) {
+				_queues.push_back(std::make_unique<PacketQueue>(capacity, packet_size));
+			}
+		}
+		
+		Distributor::Distributor(std::size_t workers, const Configuration & configuration, std::size_t capacity) : Distributor(workers, capacity, std::max(PacketQueue::DEFAULT_PACKET_SIZE, configuration.max_tx_udp_payload_size))
+		{
+			if (auto & generator = configuration.connection_id_generator) {
+				set_connection_id_generator(*generator);
+			}
+		}
+		
+		Distributor::~Distributor()
+		{
+		}
+		
+		void Distributor::set_connection_id_generator(const ConnectionIDGenerator & generator)
+		{
+			if (workers() > generator.maximum_workers()) {
+				throw std::invalid_argument("Connection IDs can't be routed to this many workers!");
+			}
+			
+			_connection_id_length = generator.length();
+			_worker_offset = generator.worker_offset();
+		}
+		
+		bool Distributor::distribute_packet(const Byte * data, std::size_t size, const Address & local_address, const Address & remote_address, ECN ecn, std::uint64_t receive_time)
+		{
+			ngtcp2_version_cid version_cid;
+			auto result = Dispatcher::decode_header(version_cid, data, size, _connection_id_length);
+			
+			// Version negotiation is handled by whichever worker the connection ID maps to:
+			if (result != 0 && result != NGTCP2_ERR_VERSION_NEGOTIATION) {
+				_drops += 1;
+				return false;
+			}
+			
+			auto index = worker(version_cid.dcid, version_cid.dcidlen);
+			
+			_pending[index] = true;
+			
+			return _queues[index]->push(data, size, local_address, remote_address, ecn, receive_time);
+		}
+		
+		void Distributor::notify()
+		{
+			for (std::size_t index = 0; index < _queues.size(); index += 1) {
+				if (_pending[index]) {
+					_pending[index] = false;
+					_queues[index]->notify();
+				}
+			}
+		}
+		
+		void Distributor::distribute(Socket & socket, ReceiveBatch & batch)
+		{
+			while (socket) {
+				while (auto packet = batch.next()) {
+					distribute_packet(packet->data, packet->size, packet->local_address, packet->remote_address, packet->ecn, packet->receive_time);
+				}
+				
+				notify();
+				
+				socket.receive_packets(batch);
+			}
+		}
+	}
+}
@@ -0,0 +1,79 @@
+//
+//  Distributor.hpp
+//  This file is part of the "Protocol::QUIC" project and released under the MIT License.
+//
+//  Created by Samuel Williams on 16/10/2026.
+//  Copyright, 2026, by Samuel Williams. All rights reserved.
+//
+
+#pragma once
+
+#include "PacketQueue.hpp"
+#include "ConnectionIDGenerator.hpp"
+#include "Configuration.hpp"
+#include "ReceiveBatch.hpp"
+#include "Socket.hpp"
+
+#include <memory>
+#include <vector>
+
+namespace Protocol
+{
+	namespace QUIC
+	{
+		// The Distributor class is the receive stage of a sharded server. Connections are owned by several worker threads, each running its own reactor and `Dispatcher` (see `Dispatcher::set_worker`), and each connection ID encodes the worker which owns it (see `ConnectionIDGenerator::worker_offset`). The distributor receives packets from the listening socket and pushes each one to its owning worker's `PacketQueue`, so that a connection's state is only ever touched by one thread. Packets for new connections are assigned by the corresponding byte of the client's chosen connection ID, so every packet of a connection reaches the same worker.
+		//
+		// Each worker should send from its own `Socket::duplicate` of the listening socket, and process packets using `Dispatcher::listen(Socket &, PacketQueue &)`.
+		class Distributor
+		{
+		public:
+			// @parameter workers the number of workers, at most 256.
+			// @parameter packet_size the largest packet which can be queued, which must be at least the workers' `Configuration::max_tx_udp_payload_size`.
+			Distributor(std::size_t workers, std::size_t capacity = PacketQueue::DEFAULT_CAPACITY, std::size_t packet_size = PacketQueue::DEFAULT_PACKET_SIZE);
+			
+			// Size the queues for the largest payload the workers' configuration sends, and decode packets using its connection ID generator.
+			Distributor(std::size_t workers, const Configuration & configuration, std::size_t capacity = PacketQueue::DEFAULT_CAPACITY);
+			~Distributor();
+			
+			Distributor(const Distributor &) = delete;
+			Distributor & operator=(const Distributor &) = delete;
+			
+			std::size_t workers() const noexcept {return _queues.size();}
+			
+			PacketQueue & queue(std::size_t worker) {return *_queues.at(worker);}
+			
+			// The number of packets dropped because their header could not be decoded.
+			std::uint64_t drops() const noexcept {return _drops;}
+			
+			// Decode packets using the connection ID length and worker offset of the generator used by the workers' servers, see `Configuration::connection_id_generator`. Throws `std::invalid_argument` if the generator can't route connections to this many workers.
+			void set_connection_id_generator(const ConnectionIDGenerator & generator);
+			
+			// @returns the index of the worker which owns the given destination connection ID.
+			std::size_t worker(const Byte * cid, std::size_t length) const noexcept
+			{
+				return length > _worker_offset ? cid[_worker_offset] % _queues.size() : 0;
+			}
+			
+			// Push a single packet to its owning worker's queue. The worker is not woken until `notify` is called.
+			// @returns false if the packet was dropped.
+			bool distribute_packet(const Byte * data, std::size_t size, const Address & local_address, const Address & remote_address, ECN ecn, std::uint64_t receive_time = 0);
+			
+			// Wake each worker which was given packets since the last call.
+			void notify();
+			
+			// Receive packets from the socket and distribute them to the workers, waking each worker once per batch. Returns when the socket is closed.
+			void distribute(Socket & socket, ReceiveBatch & batch);
+			
+		private:
+			std::vector<std::unique_ptr<PacketQueue>> _queues;
+			
+			// Whether each worker has been given packets since it was last notified:
+			std::vector<bool> _pending;
+			
+			std::uint64_t _drops = 0;
+			
+			std::size_t _connection_id_length = DEFAULT_SCID_LENGTH;
+			std::size_t _worker_offset = 0;
+		};
+	}
+}
@@ -0,0 +1,45 @@
+//
+//  ExpiringCache.cpp
+//  This file is part of the "Protocol::QUIC" project and released under the MIT License.
+//
+//  Created by Samuel Williams on 16/10/2026.
+//  Copyright, 2026, by Samuel Williams. All rights reserved.
+//
+
+#include "ExpiringCache.hpp"
+
+#include <cstring>
+
+namespace Protocol
+{
+	namespace QUIC
+	{
+		std::optional<AddressKey> AddressKey::from(const Address & address, bool port)
+		{
+			AddressKey key;
+			
+			switch (address.family()) {
+				case AF_INET:
+					key.data[0] = 4;
+					std::memcpy(key.data.data() + 1, &address.data.in.sin_addr, sizeof(address.data.in.sin_addr));
+					
+					if (port) {
+						std::memcpy(key.data.data() + 1 + sizeof(address.data.in.sin_addr), &address.data.in.sin_port, sizeof(address.data.in.sin_port));
+					}
+					
+					return key;
+				case AF_INET6:
+					key.data[0] = 6;
+					std::memcpy(key.data.data() + 1, &address.data.in6.sin6_addr, sizeof(address.data.in6.sin6_addr));
+					
+					if (port) {
+						std::memcpy(key.data.data() + 1 + sizeof(address.data.in6.sin6_addr), &address.data.in6.sin6_port, sizeof(address.data.in6.sin6_port));
+					}
+					
+					return key;
+				default:
+					return std::nullopt;
+			}
+		}
+	}
+}
@@ -0,0 +1,197 @@
+//
+//  ExpiringCache.hpp
+//  This file is part of the "Protocol::QUIC" project and released under the MIT License.
+//
+//  Created by Samuel Williams on 16/10/2026.
+//  Copyright, 2026, by Samuel Williams. All rights reserved.
+//
+
+#pragma once
+
+#include "Address.hpp"
+#include "Random.hpp"
+#include "SipHash.hpp"
+
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <list>
+#include <mutex>
+#include <optional>
+#include <unordered_map>
+
+namespace Protocol
+{
+	namespace QUIC
+	{
+		// The IP address of a peer, and optionally its port, stored inline so that it can be used as a key without allocating. The first byte is the IP version, and unused bytes are zero.
+		struct AddressKey {
+			std::array<std::uint8_t, 19> data = {};
+			
+			// @parameter port whether the port is part of the key.
+			// @returns the key, or nothing if the address isn't an IP address.
+			static std::optional<AddressKey> from(const Address & address, bool port);
+			
+			bool operator==(const AddressKey & other) const noexcept {return data == other.data;}
+		};
+		
+		// The ExpiringCache class maps peer addresses to values, each of which expires a fixed time after it was stored. Entries are kept in the order they were stored, which is also the order in which they expire, so expired entries, or if the cache is full, the oldest entry, can be evicted from the front in constant time. Connections may be created and closed on several threads, so access is serialized by a mutex.
+		template <typename ValueType>
+		class ExpiringCache
+		{
+		public:
+			using Clock = std::chrono::steady_clock;
+			
+			// @parameter port whether the port is part of the key, e.g. to distinguish servers on the same host.
+			ExpiringCache(std::size_t capacity, Clock::duration lifetime, bool port) : _capacity(capacity), _lifetime(lifetime), _port(port)
+			{
+			}
+			
+			ExpiringCache(const ExpiringCache &) = delete;
+			ExpiringCache & operator=(const ExpiringCache &) = delete;
+			
+			// The number of entries, including any which have expired but not yet been evicted.
+			std::size_t size() const
+			{
+				std::lock_guard<std::mutex> guard(_mutex);
+				
+				return _entries.size();
+			}
+			
+			// @returns the value stored for the given address, or nothing if there is none or it has expired.
+			std::optional<ValueType> lookup(const Address & address)
+			{
+				auto key = AddressKey::from(address, _port);
+				if (!key) return std::nullopt;
+				
+				std::lock_guard<std::mutex> guard(_mutex);
+				
+				auto iterator = _index.find(*key);
+				if (iterator == _index.end()) return std::nullopt;
+				
+				auto entry = iterator->second;
+				
+				if (entry->expiry <= Clock::now()) {
+					_index.erase(iterator);
+					_entries.erase(entry);
+					
+					return std::nullopt;
+				}
+				
+				return entry->value;
+			}
+			
+			// Remove and return the value stored for the given address.
+			// @returns the value, or nothing if there is none or it has expired.
+			std::optional<ValueType> take(const Address & address)
+			{
+				auto key = AddressKey::from(address, _port);
+				if (!key) return std::nullopt;
+				
+				std::lock_guard<std::mutex> guard(_mutex);
+				
+				auto iterator = _index.find(*key);
+				if (iterator == _index.end()) return std::nullopt;
+				
+				auto entry = iterator->second;
+				std::optional<ValueType> value;
+				
+				if (entry->expiry > Clock::now()) {
+					value = std::move(entry->value);
+				}
+				
+				_index.erase(iterator);
+				_entries.erase(entry);
+				
+				return value;
+			}
+			
+			// Store a value for the given address, replacing any previous value, which expires after the cache's lifetime.
+			void store(const Address & address, ValueType value)
+			{
+				auto key = AddressKey::from(address, _port);
+				if (!key || _capacity == 0) return;
+				
+				std::lock_guard<std::mutex> guard(_mutex);
+				
+				auto iterator = _index.find(*key);
+				
+				if (iterator != _index.end()) {
+					_entries.erase(iterator->second);
+					_index.erase(iterator);
+				}
+				
+				auto now = Clock::now();
+				evict(now);
+				
+				_entries.push_back(Entry{*key, std::move(value), now + _lifetime});
+				_index.emplace(*key, std::prev(_entries.end()));
+			}
+			
+			void erase(const Address & address)
+			{
+				auto key = AddressKey::from(address, _port);
+				if (!key) return;
+				
+				std::lock_guard<std::mutex> guard(_mutex);
+				
+				auto iterator = _index.find(*key);
+				
+				if (iterator != _index.end()) {
+					_entries.erase(iterator->second);
+					_index.erase(iterator);
+				}
+			}
+			
+			void clear()
+			{
+				std::lock_guard<std::mutex> guard(_mutex);
+				
+				_index.clear();
+				_entries.clear();
+			}
+			
+		private:
+			struct Entry {
+				AddressKey key;
+				ValueType value;
+				Clock::time_point expiry;
+			};
+			
+			// Keyed with a secret generated per cache, so that peers can't choose addresses which collide:
+			struct Hash {
+				SipHash hash;
+				
+				Hash()
+				{
+					Random::generate_secure(reinterpret_cast<std::uint8_t *>(&hash.k0), sizeof(hash.k0));
+					Random::generate_secure(reinterpret_cast<std::uint8_t *>(&hash.k1), sizeof(hash.k1));
+				}
+				
+				std::size_t operator()(const AddressKey & key) const noexcept
+				{
+					return hash.hash<sizeof(key.data)>(key.data.data());
+				}
+			};
+			
+			std::size_t _capacity;
+			Clock::duration _lifetime;
+			bool _port;
+			
+			mutable std::mutex _mutex;
+			
+			// In the order they were stored, and therefore the order in which they expire:
+			std::list<Entry> _entries;
+			std::unordered_map<AddressKey, typename std::list<Entry>::iterator, Hash> _index;
+			
+			// Evict expired entries, and if the cache is still full, the oldest one, which are all at the front.
+			void evict(Clock::time_point now)
+			{
+				while (!_entries.empty() && (_entries.front().expiry <= now || _entries.size() >= _capacity)) {
+					_index.erase(_entries.front().key);
+					_entries.pop_front();
+				}
+			}
+		};
+	}
+}
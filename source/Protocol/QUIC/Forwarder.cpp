@@ -0,0 +1,241 @@
+//
+//  Forwarder.cpp
+//  This file is part of the "Protocol::QUIC" project and released under the MIT License.
+//
+//  Created by Samuel Williams on 16/10/2026.
+//  Copyright, 2026, by Samuel Williams. All rights reserved.
+//
+
+#include "Forwarder.hpp"
+#include "Dispatcher.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <iostream>
+#include <system_error>
+
+namespace Protocol
+{
+	namespace QUIC
+	{
+		enum {DEBUG = 0};
+		
+		Forwarder::Flow::Flow(Forwarder & forwarder, Socket & socket, const Address & local_address, const Address & remote_address, std::size_t backend) :
+			_forwarder(forwarder),
+			_socket(socket),
+			_local_address(local_address),
+			_remote_address(remote_address),
+			_backend(backend),
+			_upstream(forwarder.backend_address(backend).family()),
+			_last_activity(timestamp())
+		{
+			_upstream.annotate("forwarding " + remote_address.to_string());
+			
+			if (!_upstream.connect(forwarder.backend_address(backend))) {
+				throw std::system_error(errno, std::generic_category(), "connect");
+			}
+		}
+		
+		Forwarder::Flow::~Flow()
+		{
+		}
+		
+		void Forwarder::Flow::relay()
+		{
+			ReceiveBatch batch;
+			Destination source = _local_address;
+			
+			while (_upstream) {
+				auto timeout = Timestamp(Timestamp::from_nanoseconds(_last_activity + _forwarder.idle_timeout()));
+				
+				if (_upstream.receive_packets(batch, &timeout) == 0) {
+					// Packets from the client also keep the flow open:
+					if (timestamp() >= _last_activity + _forwarder.idle_timeout()) break;
+					
+					continue;
+				}
+				
+				_last_activity = timestamp();
+				
+				_socket.hold();
+				
+				while (auto packet = batch.next()) {
+					_socket.send_packet(packet->data, packet->size, _remote_address, packet->ecn, nullptr, 0, 0, &source);
+				}
+				
+				_socket.flush();
+			}
+			
+			_forwarder.remove(this);
+		}
+		
+		Forwarder::Forwarder() : _flows(1024)
+		{
+			Random::generate_secure(reinterpret_cast<std::uint8_t *>(&_hash.k0), sizeof(_hash.k0));
+			Random::generate_secure(reinterpret_cast<std::uint8_t *>(&_hash.k1), sizeof(_hash.k1));
+		}
+		
+		Forwarder::~Forwarder()
+		{
+		}
+		
+		void Forwarder::add_backend(const Address & address, std::vector<std::uint8_t> server_id)
+		{
+			_backends.push_back(Backend{address, std::move(server_id)});
+		}
+		
+		void Forwarder::set_connection_id_generator(std::shared_ptr<const RoutableConnectionIDGenerator> generator)
+		{
+			_generator = std::move(generator);
+			
+			if (_generator) {
+				_connection_id_length = _generator->length();
+			}
+		}
+		
+		std::optional<std::size_t> Forwarder::select_backend(const Byte * data, std::size_t size) const
+		{
+			if (_backends.empty()) return std::nullopt;
+			
+			ngtcp2_version_cid version_cid;
+			auto result = Dispatcher::decode_header(version_cid, data, size, _connection_id_length);
+			
+			// Packets with unsupported versions are forwarded, so that the backend can negotiate the version:
+			if (result != 0 && result != NGTCP2_ERR_VERSION_NEGOTIATION) return std::nullopt;
+			
+			// Connection IDs generated by a backend name it:
+			if (_generator) {
+				std::array<std::uint8_t, 16> server_id;
+				
+				if (_generator->decode(version_cid.dcid, version_cid.dcidlen, server_id.data())) {
+					auto length = _generator->server_id().size();
+					
+					for (std::size_t index = 0; index < _backends.size(); index += 1) {
+						auto & backend = _backends[index];
+						
+						if (backend.server_id.size() == length && std::equal(backend.server_id.begin(), backend.server_id.end(), server_id.begin())) {
+							return index;
+						}
+					}
+				}
+			}
+			
+			// Otherwise, e.g. for the client's initial connection ID, the connection ID is hashed so that the client's retransmissions reach the same backend:
+			return _hash(version_cid.dcid, version_cid.dcidlen) % _backends.size();
+		}
+		
+		ConnectionID Forwarder::address_key(const Address & address)
+		{
+			ConnectionID key;
+			
+			switch (address.family()) {
+				case AF_INET:
+					std::memcpy(key.data.data(), &address.data.in.sin_addr, 4);
+					std::memcpy(key.data.data() + 4, &address.data.in.sin_port, 2);
+					key.length = 6;
+					break;
+				case AF_INET6:
+					std::memcpy(key.data.data(), &address.data.in6.sin6_addr, 16);
+					std::memcpy(key.data.data() + 16, &address.data.in6.sin6_port, 2);
+					key.length = 18;
+					break;
+			}
+			
+			return key;
+		}
+		
+		std::unique_ptr<Forwarder::Flow> Forwarder::forward_packet(Socket & socket, const ReceiveBatch::Packet & packet)
+		{
+			auto key = address_key(packet.remote_address);
+			std::unique_ptr<Flow> created;
+			Flow * flow;
+			
+			if (auto entry = _flows.find(key.data.data(), key.length)) {
+				flow = *entry;
+			} else {
+				auto backend = select_backend(packet.data, packet.size);
+				
+				if (!backend) {
+					if (DEBUG) std::cerr << "forward_packet: dropping packet from " << packet.remote_address << std::endl;
+					return nullptr;
+				}
+				
+				try {
+					created = std::make_unique<Flow>(*this, socket, packet.local_address, packet.remote_address, *backend);
+				} catch (const std::system_error & error) {
+					if (DEBUG) std::cerr << "forward_packet: dropping packet from " << packet.remote_address << ": " << error.what() << std::endl;
+					return nullptr;
+				}
+				
+				flow = created.get();
+				
+				_flows.insert(key, flow);
+			}
+			
+			if (!flow->_held) {
+				flow->_held = true;
+				flow->_upstream.hold();
+				_held.push_back(flow);
+			}
+			
+			flow->_last_activity = timestamp();
+			flow->_upstream.send_packet(packet.data, packet.size, flow->_upstream.remote_address(), packet.ecn);
+			
+			return created;
+		}
+		
+		void Forwarder::flush()
+		{
+			for (auto flow : _held) {
+				flow->_held = false;
+				flow->_upstream.flush();
+			}
+			
+			_held.clear();
+		}
+		
+		std::unique_ptr<Forwarder::Flow> Forwarder::forward(Socket & socket, ReceiveBatch & batch)
+		{
+			while (socket) {
+				std::unique_ptr<Flow> flow;
+				
+				try {
+					while (!flow) {
+						auto packet = batch.next();
+						if (!packet) break;
+						
+						flow = forward_packet(socket, *packet);
+					}
+				} catch (...) {
+					flush();
+					throw;
+				}
+				
+				flush();
+				
+				if (flow) {
+					return flow;
+				}
+				
+				socket.receive_packets(batch);
+			}
+			
+			return nullptr;
+		}
+		
+		void Forwarder::remove(Flow * flow)
+		{
+			auto key = address_key(flow->_remote_address);
+			
+			_flows.erase(key.data.data(), key.length);
+			
+			// The flow may be removed while its packets are held:
+			auto iterator = std::find(_held.begin(), _held.end(), flow);
+			
+			if (iterator != _held.end()) {
+				flow->_upstream.flush();
+				_held.erase(iterator);
+			}
+		}
+	}
+}
@@ -0,0 +1,142 @@
+//
+//  Forwarder.hpp
+//  This file is part of the "Protocol::QUIC" project and released under the MIT License.
+//
+//  Created by Samuel Williams on 16/10/2026.
+//  Copyright, 2026, by Samuel Williams. All rights reserved.
+//
+
+#pragma once
+
+#include "Socket.hpp"
+#include "ReceiveBatch.hpp"
+#include "ConnectionIDGenerator.hpp"
+#include "ConnectionIDTable.hpp"
+#include "SipHash.hpp"
+
+#include <memory>
+#include <optional>
+#include <vector>
+
+namespace Protocol
+{
+	namespace QUIC
+	{
+		// The Forwarder class is a layer 4 QUIC load balancer: it relays packets between clients and a set of backends without terminating the connections. The backend for a client is chosen by the destination connection ID of its packets, using the `Dispatcher` header classification. Connection IDs generated by a backend's `RoutableConnectionIDGenerator` name the backend, so the choice of backend doesn't depend on which forwarder receives the packet or on its state, and survives NAT rebinding and migration. Other connection IDs (e.g. the client's initial connection ID) are distributed by a keyed hash.
+		//
+		// The forwarder does keep state for each client address: packets are relayed through a `Flow`, which has its own socket connected to the backend and a fiber relaying the backend's replies to the client. A client which changes address gets a new flow to the same backend, and idle flows are closed after `idle_timeout`. Like servers, new flows are returned by `forward` so that the caller can relay the replies on a separate fiber.
+		class Forwarder
+		{
+		public:
+			// By default, flows are closed after 30 seconds without packets in either direction.
+			static constexpr std::uint64_t DEFAULT_IDLE_TIMEOUT = 30ull * 1000 * 1000 * 1000;
+			
+			class Flow
+			{
+			public:
+				Flow(Forwarder & forwarder, Socket & socket, const Address & local_address, const Address & remote_address, std::size_t backend);
+				~Flow();
+				
+				Flow(const Flow &) = delete;
+				Flow & operator=(const Flow &) = delete;
+				
+				// The address the client sent its packets to, which replies are sent from.
+				const Address & local_address() const noexcept {return _local_address;}
+				
+				// The address of the client.
+				const Address & remote_address() const noexcept {return _remote_address;}
+				
+				// The index of the backend.
+				std::size_t backend() const noexcept {return _backend;}
+				
+				// The socket connected to the backend.
+				Socket & upstream() noexcept {return _upstream;}
+				
+				// Relay packets from the backend to the client, until the flow has been idle for the forwarder's idle timeout, and then remove the flow from the forwarder.
+				void relay();
+				
+			private:
+				friend class Forwarder;
+				
+				Forwarder & _forwarder;
+				Socket & _socket;
+				
+				Address _local_address;
+				Address _remote_address;
+				std::size_t _backend;
+				
+				Socket _upstream;
+				
+				// The time of the last packet in either direction, see `timestamp()`:
+				std::uint64_t _last_activity;
+				
+				// Whether packets to the backend are being held until the end of the batch:
+				bool _held = false;
+			};
+			
+			Forwarder();
+			~Forwarder();
+			
+			Forwarder(const Forwarder &) = delete;
+			Forwarder & operator=(const Forwarder &) = delete;
+			
+			// Add a backend.
+			// @parameter server_id the server ID encoded by the backend's `RoutableConnectionIDGenerator`, if any.
+			void add_backend(const Address & address, std::vector<std::uint8_t> server_id = {});
+			
+			std::size_t backends() const noexcept {return _backends.size();}
+			const Address & backend_address(std::size_t backend) const {return _backends.at(backend).address;}
+			
+			// Decode connection IDs in the same way as the backends. The generator's configuration must match theirs, including the key, if any.
+			void set_connection_id_generator(std::shared_ptr<const RoutableConnectionIDGenerator> generator);
+			
+			// Set the connection ID length used to decode short header packets, if the backends don't use routable connection IDs.
+			void set_connection_id_length(std::size_t length) noexcept {_connection_id_length = length;}
+			
+			void set_idle_timeout(std::uint64_t nanoseconds) noexcept {_idle_timeout = nanoseconds;}
+			std::uint64_t idle_timeout() const noexcept {return _idle_timeout;}
+			
+			// The number of active flows.
+			std::size_t flows() const noexcept {return _flows.size();}
+			
+			// Choose the backend for a packet from its destination connection ID.
+			// @returns the index of the backend, or nothing if the packet can't be decoded or there are no backends.
+			std::optional<std::size_t> select_backend(const Byte * data, std::size_t size) const;
+			
+			// Receive packets from clients and relay them to their backends. Packets are received in batches, and the packets sent to each backend are sent together once the batch has been processed. If a new flow is created, it is returned immediately (the caller should run `Flow::relay` on a new fiber) and the remainder of the batch is processed on the next call.
+			std::unique_ptr<Flow> forward(Socket & socket, ReceiveBatch & batch);
+			
+			// Relay a single packet from a client. If a flow can't be created for it (e.g. the backend's address is unreachable), the packet is dropped, and the client will retransmit it.
+			// @returns the new flow, if one was created.
+			std::unique_ptr<Flow> forward_packet(Socket & socket, const ReceiveBatch::Packet & packet);
+			
+			void remove(Flow * flow);
+			
+		private:
+			struct Backend {
+				Address address;
+				std::vector<std::uint8_t> server_id;
+			};
+			
+			std::vector<Backend> _backends;
+			
+			std::shared_ptr<const RoutableConnectionIDGenerator> _generator;
+			std::size_t _connection_id_length = DEFAULT_SCID_LENGTH;
+			
+			std::uint64_t _idle_timeout = DEFAULT_IDLE_TIMEOUT;
+			
+			// Keyed with a random secret, so that clients can't choose which backend they reach:
+			SipHash _hash;
+			
+			// Flows keyed by the client address, packed into a connection ID (an IPv6 address and port is 18 bytes):
+			ConnectionIDTable<Flow *, 18> _flows;
+			
+			// Flows holding packets for their backend until the end of the current batch:
+			std::vector<Flow *> _held;
+			
+			static ConnectionID address_key(const Address & address);
+			
+			void flush();
+		};
+	}
+}
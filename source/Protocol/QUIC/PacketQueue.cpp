@@ -0,0 +1,180 @@
+//
+//  PacketQueue.cpp
+//  This file is part of the "Protocol::QUIC" project and released under the MIT License.
+//
+//  Created by Samuel Williams on 16/10/2026.
+//  Copyright, 2026, by Samuel Williams. All rights reserved.
+//
+
+#include "PacketQueue.hpp"
+
+#include <cstring>
+#include <system_error>
+
+#include <unistd.h>
+#include <fcntl.h>
+
+#if defined(__linux__)
+#include <sys/eventfd.h>
+#endif
+
+namespace Protocol
+{
+	namespace QUIC
+	{
+		static std::array<int, 2> open_notification()
+		{
+#if defined(__linux__)
+			int descriptor = eventfd(0, EFD_NONBLOCK|EFD_CLOEXEC);
+			
+			if (descriptor < 0) {
+				throw std::system_error(errno, std::generic_category(), "eventfd");
+			}
+			
+			return {descriptor, descriptor};
+#else
+			int descriptors[2];
+			
+			if (pipe(descriptors) < 0) {
+				throw std::system_error(errno, std::generic_category(), "pipe");
+			}
+			
+			for (auto descriptor : descriptors) {
+				fcntl(descriptor, F_SETFL, fcntl(descriptor, F_GETFL, 0)|O_NONBLOCK);
+				fcntl(descriptor, F_SETFD, FD_CLOEXEC);
+			}
+			
+			return {descriptors[0], descriptors[1]};
+#endif
+		}
+		
+		static std::size_t round_up(std::size_t capacity)
+		{
+			std::size_t size = 1;
+			
+			while (size < capacity) size <<= 1;
+			
+			return size;
+		}
+		
+		PacketQueue::PacketQueue(std::size_t capacity, std::size_t packet_size) :
+			_mask(round_up(capacity) - 1),
+			_packet_size(packet_size),
+			_slots(std::make_unique<Slot[]>(_mask + 1)),
+			_buffer((_mask + 1) * packet_size),
+			_descriptors(open_notification()),
+			_monitor(_descriptors[0])
+		{
+			for (std::size_t index = 0; index <= _mask; index += 1) {
+				_slots[index].sequence.store(index, std::memory_order_relaxed);
+				_slots[index].packet.data = _buffer.data() + (index * packet_size);
+			}
+		}
+		
+		PacketQueue::~PacketQueue()
+		{
+			::close(_descriptors[0]);
+			
+			if (_descriptors[1] != _descriptors[0]) {
+				::close(_descriptors[1]);
+			}
+		}
+		
+		bool PacketQueue::push(const Byte * data, std::size_t size, const Address & local_address, const Address & remote_address, ECN ecn, std::uint64_t receive_time)
+		{
+			if (size > _packet_size) {
+				_drops.fetch_add(1, std::memory_order_relaxed);
+				return false;
+			}
+			
+			auto position = _enqueue_position.load(std::memory_order_relaxed);
+			Slot * slot;
+			
+			// Claim the slot at the enqueue position, once the consumer has released it:
+			while (true) {
+				slot = &_slots[position & _mask];
+				auto sequence = slot->sequence.load(std::memory_order_acquire);
+				auto difference = static_cast<std::intptr_t>(sequence) - static_cast<std::intptr_t>(position);
+				
+				if (difference == 0) {
+					if (_enqueue_position.compare_exchange_weak(position, position + 1, std::memory_order_relaxed)) break;
+				} else if (difference < 0) {
+					// The queue is full:
+					_drops.fetch_add(1, std::memory_order_relaxed);
+					return false;
+				} else {
+					position = _enqueue_position.load(std::memory_order_relaxed);
+				}
+			}
+			
+			auto & packet = slot->packet;
+			std::memcpy(packet.data, data, size);
+			packet.size = size;
+			packet.local_address = local_address;
+			packet.remote_address = remote_address;
+			packet.ecn = ecn;
+			packet.receive_time = receive_time;
+			
+			// Publish the packet to the consumer:
+			slot->sequence.store(position + 1, std::memory_order_release);
+			
+			return true;
+		}
+		
+		void PacketQueue::notify()
+		{
+			if (_notified.exchange(true)) return;
+
+#if defined(__linux__)
+			std::uint64_t value = 1;
+#else
+			std::uint8_t value = 1;
+#endif
+			
+			// If the write fails, the descriptor is already readable, so the consumer will wake up anyway:
+			auto result = ::write(_descriptors[1], &value, sizeof(value));
+			(void)result;
+		}
+		
+		PacketQueue::Packet * PacketQueue::front() noexcept
+		{
+			auto & slot = _slots[_dequeue_position & _mask];
+			
+			if (slot.sequence.load(std::memory_order_acquire) == _dequeue_position + 1) {
+				return &slot.packet;
+			}
+			
+			return nullptr;
+		}
+		
+		void PacketQueue::pop() noexcept
+		{
+			auto & slot = _slots[_dequeue_position & _mask];
+			
+			// Release the slot to producers for the next lap around the ring:
+			slot.sequence.store(_dequeue_position + _mask + 1, std::memory_order_release);
+			_dequeue_position += 1;
+		}
+		
+		void PacketQueue::clear_notifications()
+		{
+			std::uint64_t value;
+			
+			while (::read(_descriptors[0], &value, sizeof(value)) > 0);
+			
+			// Synchronises with the producer which set the flag, so that its packets are visible to `front`:
+			_notified.exchange(false, std::memory_order_acq_rel);
+		}
+		
+		bool PacketQueue::wait(const Timestamp * timeout)
+		{
+			while (!front()) {
+				if (!_monitor.wait_readable(timeout)) return false;
+				
+				clear_notifications();
+			}
+			
+			return true;
+		}
+	}
+}
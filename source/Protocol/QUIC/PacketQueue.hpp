@@ -0,0 +1,106 @@
+//
+//  PacketQueue.hpp
+//  This file is part of the "Protocol::QUIC" project and released under the MIT License.
+//
+//  Created by Samuel Williams on 16/10/2026.
+//  Copyright, 2026, by Samuel Williams. All rights reserved.
+//
+
+#pragma once
+
+#include "Socket.hpp"
+
+#include <Scheduler/Monitor.hpp>
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+namespace Protocol
+{
+	namespace QUIC
+	{
+		// The PacketQueue class hands received packets from one or more receiving threads to a single consuming thread, without locks. It is a bounded ring of fixed size packet buffers: producers claim a slot with an atomic increment and publish it with a sequence number, and the consumer reads packets in place. The consumer waits on an eventfd (or a pipe, on other platforms), which producers signal at most once per wakeup, so that a batch of packets costs at most one system call on each side.
+		class PacketQueue
+		{
+		public:
+			static constexpr std::size_t DEFAULT_CAPACITY = 1024;
+			
+			// Large enough for a 1500 byte MTU. Larger payloads, e.g. with jumbo frames, need larger slots, see `Configuration::max_tx_udp_payload_size`.
+			static constexpr std::size_t DEFAULT_PACKET_SIZE = 1024*2;
+			
+			struct Packet {
+				Byte * data = nullptr;
+				std::size_t size = 0;
+				
+				Address remote_address;
+				Address local_address;
+				ECN ecn = ECN::UNSPECIFIED;
+				std::uint64_t receive_time = 0;
+			};
+			
+			// @parameter capacity the number of packets which can be queued, rounded up to a power of two.
+			// @parameter packet_size the largest packet which can be queued. Larger packets are dropped.
+			PacketQueue(std::size_t capacity = DEFAULT_CAPACITY, std::size_t packet_size = DEFAULT_PACKET_SIZE);
+			~PacketQueue();
+			
+			PacketQueue(const PacketQueue &) = delete;
+			PacketQueue & operator=(const PacketQueue &) = delete;
+			
+			std::size_t capacity() const noexcept {return _mask + 1;}
+			
+			// The largest packet which can be queued.
+			std::size_t packet_size() const noexcept {return _packet_size;}
+			
+			// The number of packets dropped because the queue was full or they were too large.
+			std::uint64_t drops() const noexcept {return _drops.load(std::memory_order_relaxed);}
+			
+			// Copy a packet into the queue. May be called from any thread. The consumer is not woken until `notify` is called.
+			// @returns false if the packet was dropped.
+			bool push(const Byte * data, std::size_t size, const Address & local_address, const Address & remote_address, ECN ecn, std::uint64_t receive_time = 0);
+			
+			// Wake the consumer, if it's waiting and hasn't already been woken. May be called from any thread.
+			void notify();
+			
+			// The oldest packet in the queue. Only the consumer may call this.
+			// @returns the packet, or nullptr if the queue is empty.
+			Packet * front() noexcept;
+			
+			// Release the packet returned by `front`, so that its slot can be reused.
+			void pop() noexcept;
+			
+			// Wait until the queue is not empty, or the timeout expires. Only the consumer may call this.
+			// @returns whether there are packets in the queue.
+			bool wait(const Timestamp * timeout = nullptr);
+			
+		private:
+			struct alignas(64) Slot {
+				std::atomic<std::size_t> sequence;
+				Packet packet;
+			};
+			
+			std::size_t _mask;
+			std::size_t _packet_size;
+			
+			std::unique_ptr<Slot[]> _slots;
+			std::vector<Byte> _buffer;
+			
+			// Producers and the consumer update their positions independently, so they are kept on separate cache lines:
+			alignas(64) std::atomic<std::size_t> _enqueue_position = 0;
+			alignas(64) std::size_t _dequeue_position = 0;
+			
+			// Whether the consumer has been signalled since it last woke up:
+			alignas(64) std::atomic<bool> _notified = false;
+			std::atomic<std::uint64_t> _drops = 0;
+			
+			// The descriptors which are read by the consumer and written by producers (the same eventfd on Linux):
+			std::array<int, 2> _descriptors;
+			Scheduler::Monitor _monitor;
+			
+			// Read all pending notifications.
+			void clear_notifications();
+		};
+	}
+}
@@ -0,0 +1,121 @@
+//
+//  PacketTrain.cpp
+//  This file is part of the "Protocol::QUIC" project and released under the MIT License.
+//
+//  Created by Samuel Williams on 16/10/2026.
+//  Copyright, 2026, by Samuel Williams. All rights reserved.
+//
+
+#include "PacketTrain.hpp"
+#include "Connection.hpp"
+
+#include <algorithm>
+#include <cstring>
+
+namespace Protocol
+{
+	namespace QUIC
+	{
+		PacketTrain::PacketTrain(Connection & connection) : _connection(connection)
+		{
+			ngtcp2_path_storage_zero(&_path_storage);
+			
+			_data = _buffer.data();
+			
+			// If the connection's socket supports zero-copy transmission, write the packets directly into a buffer which can be handed over to it:
+			auto path = ngtcp2_conn_get_path(connection.native_handle());
+			auto socket = static_cast<Socket *>(path->user_data);
+			
+			if (socket && socket->zero_copy() && socket->buffer_pool().buffer_size() >= BUFFER_SIZE) {
+				_socket = socket;
+				_pool_buffer = socket->buffer_pool().acquire();
+				_data = _pool_buffer.get();
+			}
+		}
+		
+		PacketTrain::~PacketTrain()
+		{
+			if (_pool_buffer) {
+				_socket->buffer_pool().release(std::move(_pool_buffer));
+			}
+		}
+		
+		bool PacketTrain::compatible(const ngtcp2_path & path, const ngtcp2_pkt_info & packet_info, std::size_t size) const
+		{
+			return ngtcp2_path_eq(&_path_storage.path, &path)
+				&& _path_storage.path.user_data == path.user_data
+				&& _packet_info.ecn == packet_info.ecn
+				&& size <= _segment_size;
+		}
+		
+		void PacketTrain::start(const ngtcp2_path & path, const ngtcp2_pkt_info & packet_info, std::size_t size)
+		{
+			auto connection = _connection.native_handle();
+			auto maximum_packet_size = std::max<std::size_t>(ngtcp2_conn_get_max_tx_udp_payload_size(connection), 1);
+			auto send_quantum = ngtcp2_conn_get_send_quantum(connection);
+			
+			ngtcp2_path_copy(&_path_storage.path, &path);
+			_packet_info = packet_info;
+			_segment_size = size;
+			
+			// Don't send more than the send quantum at once, so that the train doesn't exceed what the congestion controller expects to be sent in a burst:
+			_maximum_count = std::min({MAXIMUM_SEGMENTS, BUFFER_SIZE / maximum_packet_size, send_quantum / maximum_packet_size});
+			
+			if (_maximum_count == 0) _maximum_count = 1;
+		}
+		
+		void PacketTrain::append(const ngtcp2_path & path, const ngtcp2_pkt_info & packet_info, std::size_t size)
+		{
+			_connection.packet_written(size);
+			
+			if (_count > 0 && !compatible(path, packet_info, size)) {
+				// Send the current train and move the packet to the start of the buffer:
+				send(size);
+			}
+			
+			if (_count == 0) {
+				start(path, packet_info, size);
+			}
+			
+			_size += size;
+			_count += 1;
+			
+			// A shorter packet must be the last one in the train:
+			if (size < _segment_size || _count >= _maximum_count || available() < ngtcp2_conn_get_max_tx_udp_payload_size(_connection.native_handle())) {
+				flush();
+			}
+		}
+		
+		void PacketTrain::flush()
+		{
+			if (_count == 0) return;
+			
+			send(0);
+		}
+		
+		void PacketTrain::send(std::size_t keep)
+		{
+			auto size = _size, count = _count;
+			auto segment_size = count > 1 ? _segment_size : 0;
+			
+			_size = 0;
+			_count = 0;
+			
+			if (_pool_buffer && _path_storage.path.user_data == _socket) {
+				// Hand the buffer over to the socket, and continue writing into a new one:
+				auto buffer = std::move(_pool_buffer);
+				auto data = _data;
+				
+				_pool_buffer = _socket->buffer_pool().acquire();
+				_data = _pool_buffer.get();
+				std::memcpy(_data, data + size, keep);
+				
+				_connection.send_packet(_path_storage.path, _packet_info, std::move(buffer), size, segment_size);
+			}
+			else {
+				_connection.send_packet(_path_storage.path, _packet_info, _data, size, segment_size);
+				std::memmove(_data, _data + size, keep);
+			}
+		}
+	}
+}
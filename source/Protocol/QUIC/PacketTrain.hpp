@@ -0,0 +1,83 @@
+//
+//  PacketTrain.hpp
+//  This file is part of the "Protocol::QUIC" project and released under the MIT License.
+//
+//  Created by Samuel Williams on 16/10/2026.
+//  Copyright, 2026, by Samuel Williams. All rights reserved.
+//
+
+#pragma once
+
+#include "Socket.hpp"
+
+#include <array>
+
+#include <ngtcp2/ngtcp2.h>
+
+namespace Protocol
+{
+	namespace QUIC
+	{
+		class Connection;
+		
+		// The PacketTrain class accumulates consecutive packets written by a connection for the same path, so that they can be sent with a single system call using segmentation offload. Every packet in a train has the same size, except for the last one which may be shorter. The length of a train is limited by the connection's send quantum. If the connection's socket has zero-copy transmission enabled, the train is written directly into a buffer from the socket's pool, which is handed over to the socket when sent.
+		class PacketTrain
+		{
+		public:
+			static constexpr std::size_t BUFFER_SIZE = 1024*64;
+			
+			// The maximum number of segments the kernel will accept in one send.
+			static constexpr std::size_t MAXIMUM_SEGMENTS = 64;
+			
+			PacketTrain(Connection & connection);
+			~PacketTrain();
+			
+			PacketTrain(const PacketTrain &) = delete;
+			PacketTrain & operator=(const PacketTrain &) = delete;
+			
+			// The buffer where the next packet should be written.
+			Byte * data() noexcept {return _data + _size;}
+			
+			// The number of bytes available for the next packet.
+			std::size_t available() const noexcept {return BUFFER_SIZE - _size;}
+			
+			// The number of packets in the train.
+			std::size_t count() const noexcept {return _count;}
+			
+			// Add the packet which was written to `data()` to the train. If the packet can't be added to the current train (e.g. it's for a different path), the current train is sent first. The train is sent automatically once it's full.
+			void append(const ngtcp2_path & path, const ngtcp2_pkt_info & packet_info, std::size_t size);
+			
+			// Send any packets in the train.
+			void flush();
+			
+		private:
+			Connection & _connection;
+			
+			ngtcp2_path_storage _path_storage;
+			ngtcp2_pkt_info _packet_info;
+			
+			std::size_t _size = 0;
+			std::size_t _count = 0;
+			
+			std::size_t _segment_size = 0;
+			std::size_t _maximum_count = 1;
+			
+			std::array<Byte, BUFFER_SIZE> _buffer;
+			
+			// If the socket supports zero-copy transmission, packets are written into a buffer from its pool instead:
+			Socket * _socket = nullptr;
+			BufferPool::Buffer _pool_buffer;
+			
+			Byte * _data = nullptr;
+			
+			// Whether the packet can be added to the current train.
+			bool compatible(const ngtcp2_path & path, const ngtcp2_pkt_info & packet_info, std::size_t size) const;
+			
+			// Start a new train with the given packet's path and size.
+			void start(const ngtcp2_path & path, const ngtcp2_pkt_info & packet_info, std::size_t size);
+			
+			// Send the current train. The `keep` bytes written after the train are moved to the start of the buffer.
+			void send(std::size_t keep);
+		};
+	}
+}
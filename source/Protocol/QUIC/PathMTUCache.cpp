@@ -0,0 +1,35 @@
+//
+//  PathMTUCache.cpp
+//  This file is part of the "Protocol::QUIC" project and released under the MIT License.
+//
+//  Created by Samuel Williams on 16/10/2026.
+//  Copyright, 2026, by Samuel Williams. All rights reserved.
+//
+
+#include "PathMTUCache.hpp"
+
+namespace Protocol
+{
+	namespace QUIC
+	{
+		PathMTUCache::PathMTUCache(std::size_t capacity, Clock::duration lifetime) : _cache(capacity, lifetime, false)
+		{
+		}
+		
+		PathMTUCache::~PathMTUCache()
+		{
+		}
+		
+		std::size_t PathMTUCache::lookup(const Address & address)
+		{
+			return _cache.lookup(address).value_or(0);
+		}
+		
+		void PathMTUCache::update(const Address & address, std::size_t size)
+		{
+			if (size <= NGTCP2_MAX_UDP_PAYLOAD_SIZE) return;
+			
+			_cache.store(address, size);
+		}
+	}
+}
@@ -0,0 +1,53 @@
+//
+//  PathMTUCache.hpp
+//  This file is part of the "Protocol::QUIC" project and released under the MIT License.
+//
+//  Created by Samuel Williams on 16/10/2026.
+//  Copyright, 2026, by Samuel Williams. All rights reserved.
+//
+
+#pragma once
+
+#include "ExpiringCache.hpp"
+
+#include <cstdint>
+
+namespace Protocol
+{
+	namespace QUIC
+	{
+		// The PathMTUCache class remembers the maximum UDP payload size which path MTU discovery confirmed for each peer, keyed by IP address (the port is ignored). New connections to a known peer probe that size first rather than working up to it. Entries expire so that the learned size is eventually forgotten, in case the path has changed (RFC 8899 suggests 10 minutes).
+		class PathMTUCache
+		{
+		public:
+			using Clock = ExpiringCache<std::size_t>::Clock;
+			
+			static constexpr std::size_t DEFAULT_CAPACITY = 1024*16;
+			static constexpr Clock::duration DEFAULT_LIFETIME = std::chrono::minutes(10);
+			
+			PathMTUCache(std::size_t capacity = DEFAULT_CAPACITY, Clock::duration lifetime = DEFAULT_LIFETIME);
+			~PathMTUCache();
+			
+			PathMTUCache(const PathMTUCache &) = delete;
+			PathMTUCache & operator=(const PathMTUCache &) = delete;
+			
+			// The number of cached entries, including any which have expired but not yet been evicted.
+			std::size_t size() const {return _cache.size();}
+			
+			// @returns the maximum UDP payload size learned for the given peer, or 0 if it is unknown or has expired.
+			std::size_t lookup(const Address & address);
+			
+			// Record the maximum UDP payload size confirmed for the given peer. Sizes which are no larger than the minimum (1200 bytes) are not worth remembering, and are ignored.
+			void update(const Address & address, std::size_t size);
+			
+			// Forget the size learned for the given peer, e.g. because probes of that size were lost.
+			void erase(const Address & address) {_cache.erase(address);}
+			
+			void clear() {_cache.clear();}
+			
+		private:
+			// Keyed by IP address only:
+			ExpiringCache<std::size_t> _cache;
+		};
+	}
+}
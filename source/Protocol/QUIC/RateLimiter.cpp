@@ -0,0 +1,133 @@
+//
+//  RateLimiter.cpp
+//  This file is part of the "Protocol::QUIC" project and released under the MIT License.
+//
+//  Created by Samuel Williams on 16/10/2026.
+//  Copyright, 2026, by Samuel Williams. All rights reserved.
+//
+
+#include "RateLimiter.hpp"
+#include "Random.hpp"
+
+#include <algorithm>
+#include <cstring>
+
+namespace Protocol
+{
+	namespace QUIC
+	{
+		// Clear the bits of the address after the prefix.
+		static void mask_prefix(std::uint8_t * address, std::size_t size, std::size_t prefix_length)
+		{
+			for (std::size_t index = 0; index < size; index += 1) {
+				auto bits = index * 8;
+				
+				if (bits >= prefix_length) {
+					address[index] = 0;
+				} else if (bits + 8 > prefix_length) {
+					address[index] &= static_cast<std::uint8_t>(0xff << (bits + 8 - prefix_length));
+				}
+			}
+		}
+		
+		RateLimiter::RateLimiter(double rate, double burst, std::size_t capacity, std::uint8_t ipv4_prefix_length, std::uint8_t ipv6_prefix_length) :
+			_rate(rate),
+			_burst(std::max(burst, 1.0)),
+			_ipv4_prefix_length(std::min<std::uint8_t>(ipv4_prefix_length, 32)),
+			_ipv6_prefix_length(std::min<std::uint8_t>(ipv6_prefix_length, 128))
+		{
+			std::size_t sets = 1;
+			while (sets * WAYS < capacity) sets <<= 1;
+			
+			_sets.resize(sets);
+			clear();
+			
+			Random::generate_secure(reinterpret_cast<std::uint8_t *>(&_hash.k0), sizeof(_hash.k0));
+			Random::generate_secure(reinterpret_cast<std::uint8_t *>(&_hash.k1), sizeof(_hash.k1));
+		}
+		
+		RateLimiter::~RateLimiter()
+		{
+		}
+		
+		void RateLimiter::clear()
+		{
+			for (auto & set : _sets) {
+				set.buckets.fill(Bucket{0, 0, 0});
+			}
+		}
+		
+		std::uint64_t RateLimiter::key(const Address & address) const
+		{
+			// The prefix, preceded by the family, so that IPv4 and IPv6 prefixes never collide:
+			std::array<std::uint8_t, 17> prefix = {};
+			std::size_t size = 0;
+			
+			if (address.family() == AF_INET) {
+				prefix[0] = 4;
+				std::memcpy(prefix.data() + 1, &address.data.in.sin_addr, 4);
+				mask_prefix(prefix.data() + 1, 4, _ipv4_prefix_length);
+				size = 1 + 4;
+			} else if (address.family() == AF_INET6 && IN6_IS_ADDR_V4MAPPED(&address.data.in6.sin6_addr)) {
+				prefix[0] = 4;
+				std::memcpy(prefix.data() + 1, address.data.in6.sin6_addr.s6_addr + 12, 4);
+				mask_prefix(prefix.data() + 1, 4, _ipv4_prefix_length);
+				size = 1 + 4;
+			} else if (address.family() == AF_INET6) {
+				prefix[0] = 6;
+				std::memcpy(prefix.data() + 1, &address.data.in6.sin6_addr, 16);
+				mask_prefix(prefix.data() + 1, 16, _ipv6_prefix_length);
+				size = 1 + 16;
+			}
+			
+			auto hash = _hash(prefix.data(), size);
+			
+			return hash ? hash : 1;
+		}
+		
+		bool RateLimiter::allow(const Address & address, std::uint64_t now)
+		{
+			auto key = this->key(address);
+			auto time = static_cast<std::uint32_t>(now / (1000 * 1000));
+			
+			// The low bits choose the set; the key compared within the set is the whole hash:
+			auto & set = _sets[key & (_sets.size() - 1)];
+			
+			Bucket * bucket = nullptr;
+			Bucket * oldest = &set.buckets[0];
+			
+			for (auto & candidate : set.buckets) {
+				if (candidate.key == key) {
+					bucket = &candidate;
+					break;
+				}
+				
+				// Unused buckets have a zero key, and are treated as the oldest:
+				if (candidate.key == 0) {
+					oldest = &candidate;
+				} else if (oldest->key != 0 && (time - candidate.time) > (time - oldest->time)) {
+					oldest = &candidate;
+				}
+			}
+			
+			if (bucket) {
+				// Refill the bucket for the time since it was last used:
+				auto elapsed = static_cast<double>(time - bucket->time) / 1000.0;
+				bucket->tokens = std::min(_burst, bucket->tokens + elapsed * _rate);
+			} else {
+				// A new (or forgotten) prefix starts with a single token, so that evicting its bucket doesn't reset its limit:
+				bucket = oldest;
+				bucket->key = key;
+				bucket->tokens = 1;
+			}
+			
+			bucket->time = time;
+			
+			if (bucket->tokens < 1) return false;
+			
+			bucket->tokens -= 1;
+			
+			return true;
+		}
+	}
+}
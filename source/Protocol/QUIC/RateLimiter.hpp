@@ -0,0 +1,80 @@
+//
+//  RateLimiter.hpp
+//  This file is part of the "Protocol::QUIC" project and released under the MIT License.
+//
+//  Created by Samuel Williams on 16/10/2026.
+//  Copyright, 2026, by Samuel Williams. All rights reserved.
+//
+
+#pragma once
+
+#include "Address.hpp"
+#include "SipHash.hpp"
+
+#include <array>
+#include <cstdint>
+#include <vector>
+
+namespace Protocol
+{
+	namespace QUIC
+	{
+		// The RateLimiter class limits the rate of events (e.g. new connections) from each source prefix with a token bucket. Sources are grouped by prefix (e.g. an IPv4 /24 or an IPv6 /56), as a single host usually controls many addresses. IPv4-mapped IPv6 addresses use the IPv4 prefix length.
+		//
+		// The buckets are stored in a fixed size, set associative table: each prefix hashes (with a random key) to one cache line holding a few buckets, and the least recently used bucket in the set is replaced when a new prefix arrives. Buckets which haven't been used for a while are therefore forgotten. A new (or forgotten) prefix starts with a single token rather than a full burst, which only accumulates while the prefix is tracked, so a source cycling through enough prefixes to evict its buckets gains no more than one event per prefix. Nothing is allocated after construction. Not thread safe; each dispatcher should have its own limiter.
+		class RateLimiter
+		{
+		public:
+			static constexpr std::size_t DEFAULT_CAPACITY = 1024*16;
+			
+			// The number of buckets in each set, which fill one cache line:
+			static constexpr std::size_t WAYS = 4;
+			
+			// @parameter rate the number of events allowed per second, per prefix.
+			// @parameter burst the number of events allowed at once, per prefix, i.e. the size of the bucket. New buckets start with one token.
+			// @parameter capacity the number of buckets, rounded up to a power of two sets.
+			RateLimiter(double rate, double burst, std::size_t capacity = DEFAULT_CAPACITY, std::uint8_t ipv4_prefix_length = 24, std::uint8_t ipv6_prefix_length = 56);
+			~RateLimiter();
+			
+			RateLimiter(const RateLimiter &) = delete;
+			RateLimiter & operator=(const RateLimiter &) = delete;
+			
+			std::size_t capacity() const noexcept {return _sets.size() * WAYS;}
+			
+			// Consume a token from the bucket of the address's prefix, if one is available.
+			// @parameter now the current time in nanoseconds, see `timestamp()`.
+			// @returns whether the event is within the limit.
+			bool allow(const Address & address, std::uint64_t now);
+			
+			// Forget all the buckets.
+			void clear();
+			
+		private:
+			struct Bucket {
+				// The hash of the prefix, or zero if the bucket is unused:
+				std::uint64_t key;
+				
+				// The time of the last update, in milliseconds (wraps around after 49 days):
+				std::uint32_t time;
+				
+				float tokens;
+			};
+			
+			struct alignas(64) Set {
+				std::array<Bucket, WAYS> buckets;
+			};
+			
+			double _rate;
+			double _burst;
+			
+			std::uint8_t _ipv4_prefix_length;
+			std::uint8_t _ipv6_prefix_length;
+			
+			SipHash _hash;
+			std::vector<Set> _sets;
+			
+			// Hash the prefix of the address, which is never zero.
+			std::uint64_t key(const Address & address) const;
+		};
+	}
+}
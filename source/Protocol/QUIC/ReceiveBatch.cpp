@@ -0,0 +1,101 @@
+//
+//  ReceiveBatch.cpp
+//  This file is part of the "Protocol::QUIC" project and released under the MIT License.
+//
+//  Created by Samuel Williams on 16/10/2026.
+//  Copyright, 2026, by Samuel Williams. All rights reserved.
+//
+
+#include "ReceiveBatch.hpp"
+
+#include <algorithm>
+#include <cassert>
+
+namespace Protocol
+{
+	namespace QUIC
+	{
+		ReceiveBatch::ReceiveBatch(std::size_t capacity, std::size_t packet_size) :
+			_capacity(capacity),
+			_packet_size(packet_size),
+			_buffer(capacity * packet_size),
+			_packets(capacity),
+			_lengths(capacity),
+			_messages(capacity),
+			_iovecs(capacity),
+			_control(capacity * CONTROL_SIZE)
+		{
+			assert(capacity > 0);
+		}
+		
+		ReceiveBatch::~ReceiveBatch()
+		{
+		}
+		
+		ReceiveBatch::Packet * ReceiveBatch::next()
+		{
+			if (_offset < _received) {
+				auto & packet = _packets[_offset];
+				auto remaining = _lengths[_offset] - _position;
+				
+				packet.data = _buffer.data() + (_offset * _packet_size) + _position;
+				packet.size = packet.segment_size ? std::min(packet.segment_size, remaining) : remaining;
+				
+				_position += packet.size;
+				
+				// Move to the next datagram once this one has been consumed:
+				if (_position >= _lengths[_offset]) {
+					_offset += 1;
+					_position = 0;
+				}
+				
+				return &packet;
+			}
+			
+			return nullptr;
+		}
+		
+		void ReceiveBatch::clear()
+		{
+			_size = 0;
+			_received = 0;
+			_offset = 0;
+			_position = 0;
+		}
+		
+		Message * ReceiveBatch::prepare()
+		{
+			clear();
+			
+			for (std::size_t index = 0; index < _capacity; index += 1) {
+				auto & packet = _packets[index];
+				auto & iov = _iovecs[index];
+				auto & message = _messages[index];
+				
+				iov.iov_base = _buffer.data() + (index * _packet_size);
+				iov.iov_len = _packet_size;
+				
+				packet.data = static_cast<Byte *>(iov.iov_base);
+				packet.size = 0;
+				
+				message.msg_hdr = msghdr{};
+				
+				// Provide the address data pointer / length:
+				message.msg_hdr.msg_name = &packet.remote_address.data;
+				message.msg_hdr.msg_namelen = sizeof(packet.remote_address.data);
+				
+				// Provide the data buffer io vectors:
+				message.msg_hdr.msg_iov = &iov;
+				message.msg_hdr.msg_iovlen = 1;
+				
+				// Provide the message control buffer (for reading the ecn):
+				message.msg_hdr.msg_control = _control.data() + (index * CONTROL_SIZE);
+				message.msg_hdr.msg_controllen = CONTROL_SIZE;
+				
+				message.msg_len = 0;
+			}
+			
+			return _messages.data();
+		}
+	}
+}
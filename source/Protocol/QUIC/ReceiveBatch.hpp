@@ -0,0 +1,102 @@
+//
+//  ReceiveBatch.hpp
+//  This file is part of the "Protocol::QUIC" project and released under the MIT License.
+//
+//  Created by Samuel Williams on 16/10/2026.
+//  Copyright, 2026, by Samuel Williams. All rights reserved.
+//
+
+#pragma once
+
+#include "Socket.hpp"
+
+#include <cstdint>
+#include <vector>
+
+#include <sys/socket.h>
+
+namespace Protocol
+{
+	namespace QUIC
+	{
+		// The ReceiveBatch class holds the storage required to receive several datagrams from a socket with a single system call. Packets are consumed one at a time using `next()`, and the batch is refilled by `Socket::receive_packets` once it has been drained. Datagrams which were coalesced by the kernel (generic receive offload) are split back into individual packets by `next()`.
+		class ReceiveBatch
+		{
+		public:
+			static constexpr std::size_t DEFAULT_CAPACITY = 16;
+			static constexpr std::size_t DEFAULT_PACKET_SIZE = 1024*64;
+			
+			// The size of the ancillary data buffer reserved for each message.
+			static constexpr std::size_t CONTROL_SIZE = 256;
+			
+			struct Packet {
+				Byte * data = nullptr;
+				std::size_t size = 0;
+				
+				// The address of the sender (remote peer).
+				Address remote_address;
+				
+				// The address the packet was sent to, which is specific even if the socket is bound to a wildcard address.
+				Address local_address;
+				ECN ecn = ECN::UNSPECIFIED;
+				
+				// If non-zero, the datagram was coalesced from several packets of this size (the last may be shorter).
+				std::size_t segment_size = 0;
+				
+				// If non-zero, the time at which the kernel received the datagram, in nanoseconds on the monotonic clock (the same clock as `timestamp()`).
+				std::uint64_t receive_time = 0;
+			};
+			
+			ReceiveBatch(std::size_t capacity = DEFAULT_CAPACITY, std::size_t packet_size = DEFAULT_PACKET_SIZE);
+			~ReceiveBatch();
+			
+			ReceiveBatch(const ReceiveBatch &) = delete;
+			ReceiveBatch & operator=(const ReceiveBatch &) = delete;
+			
+			// The maximum number of packets which can be received at once.
+			std::size_t capacity() const noexcept {return _capacity;}
+			
+			// The number of packets received by the most recent call to `Socket::receive_packets`, after splitting coalesced datagrams.
+			std::size_t size() const noexcept {return _size;}
+			
+			// Whether all the received packets have been consumed.
+			bool empty() const noexcept {return _offset >= _received;}
+			
+			// Consume the next received packet.
+			// @returns the next packet, or nullptr if the batch has been drained.
+			Packet * next();
+			
+			// Discard any packets which have not been consumed.
+			void clear();
+			
+		private:
+			friend class Socket;
+			
+			std::size_t _capacity;
+			std::size_t _packet_size;
+			
+			std::size_t _size = 0;
+			
+			// The number of datagrams received:
+			std::size_t _received = 0;
+			
+			// The datagram being consumed, and the offset of the next packet within it:
+			std::size_t _offset = 0;
+			std::size_t _position = 0;
+			
+			std::vector<Byte> _buffer;
+			std::vector<Packet> _packets;
+			
+			// The length of each received datagram:
+			std::vector<std::size_t> _lengths;
+			
+			// Message headers, io vectors and control buffers, reused by every receive:
+			std::vector<Message> _messages;
+			std::vector<iovec> _iovecs;
+			std::vector<Byte> _control;
+			
+			// Prepare the message headers for receiving into the batch.
+			Message * prepare();
+		};
+	}
+}
@@ -0,0 +1,467 @@
+//
+//  Ring.cpp
+//  This file is part of the "Protocol::QUIC" project and released under the MIT License.
+//
+//  Created by Samuel Williams on 16/10/2026.
+//  Copyright, 2026, by Samuel Williams. All rights reserved.
+//
+
+#include "Ring.hpp"
+#include "ReceiveBatch.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <system_error>
+#include <cerrno>
+
+#include <unistd.h>
+
+// Supported on Linux.
+#if defined(__linux__) && __has_include(<linux/io_uring.h>)
+#define PROTOCOL_QUIC_RING
+
+#include <linux/io_uring.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#else
+struct io_uring_params {};
+#endif
+
+namespace Protocol
+{
+	namespace QUIC
+	{
+#if defined(PROTOCOL_QUIC_RING)
+		// The user data used to identify completions of the multishot receive. Send completions use the index of the message.
+		constexpr std::uint64_t RECEIVE = UINT64_MAX;
+		constexpr std::uint64_t CANCEL = UINT64_MAX - 1;
+		
+		constexpr std::uint16_t BUFFER_GROUP = 0;
+		
+		bool Ring::supported() noexcept
+		{
+			return true;
+		}
+		
+		int Ring::setup(std::size_t entries, io_uring_params & parameters)
+		{
+			int descriptor = syscall(__NR_io_uring_setup, entries, &parameters);
+			
+			if (descriptor < 0) {
+				throw std::system_error(errno, std::generic_category(), "io_uring_setup");
+			}
+			
+			return descriptor;
+		}
+		
+		Ring::Ring(int socket, std::size_t entries, std::size_t buffer_count, std::size_t buffer_size) :
+			_socket(socket),
+			_parameters(std::make_unique<io_uring_params>()),
+			_descriptor(setup(entries, *_parameters)),
+			_monitor(_descriptor),
+			_buffer_count(buffer_count),
+			_buffer_size(buffer_size),
+			_buffers(buffer_count * buffer_size)
+		{
+			assert((buffer_count & (buffer_count - 1)) == 0);
+			
+			_message = msghdr{};
+			_message.msg_namelen = sizeof(sockaddr_storage);
+			_message.msg_controllen = ReceiveBatch::CONTROL_SIZE;
+			
+			try {
+				map();
+				register_buffers();
+				
+				arm();
+				enter(1, 0);
+				reap();
+				
+				// Kernels which don't support multishot receive (or provided buffer rings) fail immediately:
+				if (!_armed) {
+					auto error = _completions.empty() ? ENOTSUP : -_completions.front().result;
+					
+					throw std::system_error(error, std::generic_category(), "io_uring recvmsg");
+				}
+			} catch (...) {
+				close();
+				throw;
+			}
+		}
+		
+		Ring::~Ring()
+		{
+			close();
+		}
+		
+		void Ring::close()
+		{
+			if (_armed) {
+				// Cancel the multishot receive, so the kernel is no longer using the buffers:
+				if (auto sqe = next_sqe()) {
+					sqe->opcode = IORING_OP_ASYNC_CANCEL;
+					sqe->addr = RECEIVE;
+					sqe->user_data = CANCEL;
+					
+					enter(1, 0);
+					
+					while (_armed) {
+						if (enter(0, 1) < 0) break;
+						reap();
+					}
+				}
+			}
+			
+			if (_buffer_ring) {
+				munmap(_buffer_ring, _buffer_ring_size);
+				_buffer_ring = nullptr;
+			}
+			
+			if (_sqes) {
+				munmap(_sqes, _sqes_size);
+				_sqes = nullptr;
+			}
+			
+			if (_queues) {
+				munmap(_queues, _queues_size);
+				_queues = nullptr;
+			}
+			
+			if (_descriptor >= 0) {
+				::close(_descriptor);
+				_descriptor = -1;
+			}
+		}
+		
+		void Ring::map()
+		{
+			auto & parameters = *_parameters;
+			
+			// Older kernels require the queues to be mapped separately, which we don't bother supporting:
+			if (!(parameters.features & IORING_FEAT_SINGLE_MMAP)) {
+				throw std::system_error(ENOTSUP, std::generic_category(), "io_uring_setup");
+			}
+			
+			auto sq_size = parameters.sq_off.array + parameters.sq_entries * sizeof(unsigned);
+			auto cq_size = parameters.cq_off.cqes + parameters.cq_entries * sizeof(io_uring_cqe);
+			
+			_queues_size = std::max<std::size_t>(sq_size, cq_size);
+			auto queues = mmap(nullptr, _queues_size, PROT_READ|PROT_WRITE, MAP_SHARED|MAP_POPULATE, _descriptor, IORING_OFF_SQ_RING);
+			
+			if (queues == MAP_FAILED) {
+				throw std::system_error(errno, std::generic_category(), "mmap");
+			}
+			
+			_queues = queues;
+			
+			_sqes_size = parameters.sq_entries * sizeof(io_uring_sqe);
+			auto sqes = mmap(nullptr, _sqes_size, PROT_READ|PROT_WRITE, MAP_SHARED|MAP_POPULATE, _descriptor, IORING_OFF_SQES);
+			
+			if (sqes == MAP_FAILED) {
+				throw std::system_error(errno, std::generic_category(), "mmap");
+			}
+			
+			_sqes = static_cast<io_uring_sqe *>(sqes);
+			
+			auto base = static_cast<Byte *>(_queues);
+			
+			_sq_head = reinterpret_cast<unsigned *>(base + parameters.sq_off.head);
+			_sq_tail = reinterpret_cast<unsigned *>(base + parameters.sq_off.tail);
+			_sq_array = reinterpret_cast<unsigned *>(base + parameters.sq_off.array);
+			_sq_mask = *reinterpret_cast<unsigned *>(base + parameters.sq_off.ring_mask);
+			_sq_entries = parameters.sq_entries;
+			
+			_cq_head = reinterpret_cast<unsigned *>(base + parameters.cq_off.head);
+			_cq_tail = reinterpret_cast<unsigned *>(base + parameters.cq_off.tail);
+			_cqes = reinterpret_cast<io_uring_cqe *>(base + parameters.cq_off.cqes);
+			_cq_mask = *reinterpret_cast<unsigned *>(base + parameters.cq_off.ring_mask);
+		}
+		
+		void Ring::register_buffers()
+		{
+			_buffer_ring_size = _buffer_count * sizeof(io_uring_buf);
+			auto buffer_ring = mmap(nullptr, _buffer_ring_size, PROT_READ|PROT_WRITE, MAP_ANONYMOUS|MAP_PRIVATE, -1, 0);
+			
+			if (buffer_ring == MAP_FAILED) {
+				throw std::system_error(errno, std::generic_category(), "mmap");
+			}
+			
+			_buffer_ring = static_cast<io_uring_buf_ring *>(buffer_ring);
+			
+			io_uring_buf_reg registration{};
+			registration.ring_addr = reinterpret_cast<std::uint64_t>(_buffer_ring);
+			registration.ring_entries = _buffer_count;
+			registration.bgid = BUFFER_GROUP;
+			
+			if (syscall(__NR_io_uring_register, _descriptor, IORING_REGISTER_PBUF_RING, &registration, 1) < 0) {
+				throw std::system_error(errno, std::generic_category(), "io_uring_register");
+			}
+			
+			for (std::size_t index = 0; index < _buffer_count; index += 1) {
+				release(index);
+			}
+		}
+		
+		void Ring::release(unsigned index)
+		{
+			// We are the only producer, so the tail can be read directly:
+			auto tail = _buffer_ring->tail;
+			auto & buffer = _buffer_ring->bufs[tail & (_buffer_count - 1)];
+			
+			buffer.addr = reinterpret_cast<std::uint64_t>(_buffers.data() + (index * _buffer_size));
+			buffer.len = _buffer_size;
+			buffer.bid = index;
+			
+			__atomic_store_n(&_buffer_ring->tail, tail + 1, __ATOMIC_RELEASE);
+		}
+		
+		io_uring_sqe * Ring::next_sqe()
+		{
+			auto head = __atomic_load_n(_sq_head, __ATOMIC_ACQUIRE);
+			auto tail = *_sq_tail;
+			
+			if (tail - head >= _sq_entries) {
+				return nullptr;
+			}
+			
+			auto index = tail & _sq_mask;
+			auto sqe = &_sqes[index];
+			
+			*sqe = io_uring_sqe{};
+			_sq_array[index] = index;
+			
+			// The entry is not consumed by the kernel until `enter` is called:
+			__atomic_store_n(_sq_tail, tail + 1, __ATOMIC_RELEASE);
+			
+			return sqe;
+		}
+		
+		int Ring::enter(unsigned submit, unsigned wait)
+		{
+			unsigned flags = wait ? IORING_ENTER_GETEVENTS : 0;
+			int result;
+			
+			do {
+				result = syscall(__NR_io_uring_enter, _descriptor, submit, wait, flags, nullptr, 0);
+			} while (result == -1 && errno == EINTR);
+			
+			return result;
+		}
+		
+		void Ring::reap()
+		{
+			auto head = *_cq_head;
+			auto tail = __atomic_load_n(_cq_tail, __ATOMIC_ACQUIRE);
+			
+			for (; head != tail; head += 1) {
+				auto & cqe = _cqes[head & _cq_mask];
+				
+				if (cqe.user_data == RECEIVE) {
+					if (!(cqe.flags & IORING_CQE_F_MORE)) {
+						_armed = false;
+					}
+					
+					if (cqe.res == -ECANCELED) continue;
+					
+					_completions.push_back({cqe.res, cqe.flags});
+				}
+				else if (cqe.user_data < _send_results.size()) {
+					_send_results[cqe.user_data] = cqe.res;
+					_send_pending -= 1;
+				}
+			}
+			
+			__atomic_store_n(_cq_head, head, __ATOMIC_RELEASE);
+		}
+		
+		void Ring::arm()
+		{
+			if (_armed) return;
+			
+			if (auto sqe = next_sqe()) {
+				sqe->opcode = IORING_OP_RECVMSG;
+				sqe->fd = _socket;
+				sqe->addr = reinterpret_cast<std::uint64_t>(&_message);
+				sqe->len = 1;
+				sqe->flags = IOSQE_BUFFER_SELECT;
+				sqe->buf_group = BUFFER_GROUP;
+				sqe->ioprio = IORING_RECV_MULTISHOT;
+				sqe->user_data = RECEIVE;
+				
+				_armed = true;
+			}
+		}
+		
+		int Ring::receive(Message * messages, std::size_t count)
+		{
+			reap();
+			
+			if (_completions.empty() && !_armed) {
+				arm();
+				enter(1, 0);
+				reap();
+			}
+			
+			if (_completions.empty()) {
+				errno = EAGAIN;
+				return -1;
+			}
+			
+			std::size_t index = 0;
+			
+			while (index < count && !_completions.empty()) {
+				auto completion = _completions.front();
+				
+				// Running out of buffers stops the multishot receive, which is restarted once buffers are released:
+				if (completion.result == -ENOBUFS) {
+					_completions.pop_front();
+					continue;
+				}
+				
+				if (completion.result < 0) {
+					// Report the error once the preceding messages have been consumed:
+					if (index > 0) break;
+					
+					_completions.pop_front();
+					errno = -completion.result;
+					return -1;
+				}
+				
+				_completions.pop_front();
+				
+				unsigned buffer_index = completion.flags >> IORING_CQE_BUFFER_SHIFT;
+				auto buffer = _buffers.data() + (buffer_index * _buffer_size);
+				auto header = reinterpret_cast<io_uring_recvmsg_out *>(buffer);
+				
+				// The buffer contains the header, followed by the address, control data and payload, as laid out by `_message`:
+				auto name = buffer + sizeof(io_uring_recvmsg_out);
+				auto control = name + _message.msg_namelen;
+				auto payload = control + _message.msg_controllen;
+				
+				auto & message = messages[index];
+				auto & output = message.msg_hdr;
+				
+				output.msg_namelen = std::min<socklen_t>(header->namelen, output.msg_namelen);
+				std::memcpy(output.msg_name, name, output.msg_namelen);
+				
+				output.msg_controllen = std::min<std::size_t>(header->controllen, output.msg_controllen);
+				std::memcpy(output.msg_control, control, output.msg_controllen);
+				
+				// The payload length is reported before truncation:
+				auto length = std::min<std::size_t>(header->payloadlen, buffer + _buffer_size - payload);
+				length = std::min(length, output.msg_iov[0].iov_len);
+				std::memcpy(output.msg_iov[0].iov_base, payload, length);
+				
+				output.msg_flags = header->flags;
+				message.msg_len = length;
+				
+				release(buffer_index);
+				index += 1;
+			}
+			
+			// Restart the receive if it stopped, now that buffers have been released:
+			if (!_armed) {
+				arm();
+				enter(1, 0);
+			}
+			
+			if (index == 0) {
+				errno = EAGAIN;
+				return -1;
+			}
+			
+			return index;
+		}
+		
+		int Ring::send(Message * messages, std::size_t count)
+		{
+			count = std::min<std::size_t>(count, _sq_entries);
+			
+			_send_results.assign(count, -ECANCELED);
+			_send_pending = 0;
+			
+			for (std::size_t index = 0; index < count; index += 1) {
+				auto sqe = next_sqe();
+				if (!sqe) break;
+				
+				sqe->opcode = IORING_OP_SENDMSG;
+				sqe->fd = _socket;
+				sqe->addr = reinterpret_cast<std::uint64_t>(&messages[index].msg_hdr);
+				sqe->len = 1;
+				
+				// Don't wait for the socket to become writable, so that all the operations complete during submission:
+				sqe->msg_flags = MSG_DONTWAIT;
+				sqe->user_data = index;
+				
+				if (index + 1 < count) {
+					sqe->flags = IOSQE_IO_LINK;
+				}
+				
+				_send_pending += 1;
+			}
+			
+			if (enter(_send_pending, _send_pending) < 0) {
+				_send_results.clear();
+				return -1;
+			}
+			
+			reap();
+			
+			while (_send_pending > 0) {
+				if (enter(0, 1) < 0) {
+					_send_results.clear();
+					return -1;
+				}
+				
+				reap();
+			}
+			
+			std::size_t sent = 0;
+			
+			for (; sent < _send_results.size() && _send_results[sent] >= 0; sent += 1) {
+				messages[sent].msg_len = _send_results[sent];
+			}
+			
+			if (sent == 0 && !_send_results.empty()) {
+				errno = -_send_results.front();
+				_send_results.clear();
+				return -1;
+			}
+			
+			_send_results.clear();
+			
+			return sent;
+		}
+#else
+		bool Ring::supported() noexcept
+		{
+			return false;
+		}
+		
+		Ring::Ring(int socket, std::size_t entries, std::size_t buffer_count, std::size_t buffer_size) :
+			_socket(socket),
+			_monitor(_descriptor),
+			_buffer_count(buffer_count),
+			_buffer_size(buffer_size)
+		{
+			throw std::system_error(ENOSYS, std::generic_category(), "io_uring_setup");
+		}
+		
+		Ring::~Ring()
+		{
+		}
+		
+		int Ring::receive(Message * messages, std::size_t count)
+		{
+			errno = ENOSYS;
+			return -1;
+		}
+		
+		int Ring::send(Message * messages, std::size_t count)
+		{
+			errno = ENOSYS;
+			return -1;
+		}
+#endif
+	}
+}
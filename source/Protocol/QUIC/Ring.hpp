@@ -0,0 +1,133 @@
+//
+//  Ring.hpp
+//  This file is part of the "Protocol::QUIC" project and released under the MIT License.
+//
+//  Created by Samuel Williams on 16/10/2026.
+//  Copyright, 2026, by Samuel Williams. All rights reserved.
+//
+
+#pragma once
+
+#include "Socket.hpp"
+
+#include <deque>
+#include <memory>
+#include <vector>
+
+struct io_uring_params;
+struct io_uring_sqe;
+struct io_uring_cqe;
+struct io_uring_buf_ring;
+
+namespace Protocol
+{
+	namespace QUIC
+	{
+		// The Ring class is an io_uring instance which performs the I/O for a single socket. Datagrams are received by a multishot `recvmsg` into a ring of buffers provided to the kernel, so that one submission keeps receiving until the buffers run out. Sends are submitted as a batch of linked `sendmsg` operations with a single system call. The interface mirrors `recvmmsg` and `sendmmsg` so that the socket can use either backend.
+		class Ring
+		{
+		public:
+			static constexpr std::size_t DEFAULT_ENTRIES = 256;
+			
+			// The number of provided buffers, which must be a power of two.
+			static constexpr std::size_t DEFAULT_BUFFER_COUNT = 64;
+			
+			// Each provided buffer holds the received address and control data, followed by the payload.
+			static constexpr std::size_t DEFAULT_BUFFER_SIZE = 1024*65;
+			
+			// Whether io_uring is supported on this platform. It may still be unavailable at runtime.
+			static bool supported() noexcept;
+			
+			// @throws std::system_error if the kernel does not support the required io_uring features.
+			Ring(int socket, std::size_t entries = DEFAULT_ENTRIES, std::size_t buffer_count = DEFAULT_BUFFER_COUNT, std::size_t buffer_size = DEFAULT_BUFFER_SIZE);
+			~Ring();
+			
+			Ring(const Ring &) = delete;
+			Ring & operator=(const Ring &) = delete;
+			
+			int descriptor() const noexcept {return _descriptor;}
+			
+			// The monitor for the completion queue, which becomes readable when received datagrams are available.
+			Scheduler::Monitor & monitor() noexcept {return _monitor;}
+			
+			// Copy received datagrams into the messages without blocking, like `recvmmsg`.
+			// @returns the number of messages received, or -1 if an error occurred (errno is set to EAGAIN if nothing was available).
+			int receive(Message * messages, std::size_t count);
+			
+			// Send the messages with a single submission, like `sendmmsg`. The operations are non-blocking and linked, so if one fails, the rest are not sent.
+			// @returns the number of messages sent, or -1 if an error occurred sending the first message (errno is set).
+			int send(Message * messages, std::size_t count);
+			
+		private:
+			int _socket;
+			
+			std::unique_ptr<io_uring_params> _parameters;
+			
+			int _descriptor = -1;
+			Scheduler::Monitor _monitor;
+			
+			// The submission and completion queues, shared with the kernel:
+			void * _queues = nullptr;
+			std::size_t _queues_size = 0;
+			
+			io_uring_sqe * _sqes = nullptr;
+			std::size_t _sqes_size = 0;
+			
+			unsigned * _sq_head = nullptr;
+			unsigned * _sq_tail = nullptr;
+			unsigned * _sq_array = nullptr;
+			unsigned _sq_mask = 0;
+			unsigned _sq_entries = 0;
+			
+			unsigned * _cq_head = nullptr;
+			unsigned * _cq_tail = nullptr;
+			io_uring_cqe * _cqes = nullptr;
+			unsigned _cq_mask = 0;
+			
+			// The provided buffers, and the ring used to return them to the kernel:
+			io_uring_buf_ring * _buffer_ring = nullptr;
+			std::size_t _buffer_ring_size = 0;
+			std::size_t _buffer_count;
+			std::size_t _buffer_size;
+			std::vector<Byte> _buffers;
+			
+			// The message template used by the multishot receive, which describes the layout of each provided buffer:
+			msghdr _message;
+			
+			// Whether the multishot receive is still active:
+			bool _armed = false;
+			
+			struct Completion {
+				int result;
+				unsigned flags;
+			};
+			
+			// Receive completions which have been reaped but not yet consumed:
+			std::deque<Completion> _completions;
+			
+			// The results of the send operations in the current submission:
+			std::vector<int> _send_results;
+			std::size_t _send_pending = 0;
+			
+			int setup(std::size_t entries, io_uring_params & parameters);
+			void close();
+			void map();
+			void register_buffers();
+			
+			// Get a submission queue entry, or nullptr if the queue is full.
+			io_uring_sqe * next_sqe();
+			
+			// Submit all pending entries and wait for the given number of completions.
+			int enter(unsigned submit, unsigned wait);
+			
+			// Process all the available completions.
+			void reap();
+			
+			// Return a provided buffer to the kernel.
+			void release(unsigned index);
+			
+			// Start the multishot receive if it's not already active.
+			void arm();
+		};
+	}
+}
@@ -8,12 +8,16 @@
 
 #include "Server.hpp"
 #include "Dispatcher.hpp"
+#include "Configuration.hpp"
 
 #include <Scheduler/After.hpp>
 
+#include <array>
 #include <iostream>
+#include <string>
 
 #include "ngtcp2/ngtcp2.h"
+#include "ngtcp2/ngtcp2_crypto.h"
 
 namespace Protocol
 {
@@ -22,10 +26,15 @@ namespace Protocol
 		void Server::setup(TLS::ServerContext & tls_context, const ngtcp2_cid *dcid, const ngtcp2_cid *scid, const ngtcp2_path *path, uint32_t client_chosen_version, ngtcp2_settings *settings, ngtcp2_transport_params *params, const ngtcp2_mem *mem)
 		{
 			auto callbacks = ngtcp2_callbacks{};
-			Connection::setup(&callbacks, settings, params);
+			Connection::setup(&callbacks, settings, params, path);
 			
-			// Random::generate_secure(params->stateless_reset_token, sizeof(params->stateless_reset_token));
-			// params->stateless_reset_token_present = 1;
+			// The token is derived from the static secret, so that the dispatcher can reset the connection statelessly if it is lost, e.g. after a restart:
+			auto & static_secret = _configuration.static_secret;
+			if (ngtcp2_crypto_generate_stateless_reset_token(params->stateless_reset_token, static_secret.data(), static_secret.size(), scid) != 0) {
+				throw std::runtime_error("Failed to generate stateless reset token!");
+			}
+			
+			params->stateless_reset_token_present = 1;
 			
 			if (ngtcp2_conn_server_new(&_connection, dcid, scid, path, client_chosen_version, &callbacks, settings, params, mem, this)) {
 				throw std::runtime_error("Failed to create QUIC server connection!");
@@ -34,7 +43,7 @@ namespace Protocol
 			_tls_session = std::make_unique<TLS::ServerSession>(tls_context, _connection);
 		}
 		
-		Server::Server(Dispatcher & binding, Configuration & configuration, TLS::ServerContext & tls_context, Socket & socket, const Address & remote_address, const ngtcp2_pkt_hd & packet_header, ngtcp2_cid *ocid) : Connection(configuration), _dispatcher(binding)
+		Server::Server(Dispatcher & binding, Configuration & configuration, TLS::ServerContext & tls_context, Socket & socket, const Address & local_address, const Address & remote_address, const ngtcp2_pkt_hd & packet_header, ngtcp2_cid *ocid) : Connection(configuration), _dispatcher(binding), _listening_socket(socket)
 		{
 			// Generate the server connection ID:
 			generate_cid(&_scid);
@@ -49,16 +58,25 @@ namespace Protocol
 			ngtcp2_transport_params_default(&params);
 			
 			if (ocid) {
+				// The client's address was validated by a Retry token:
+				settings.token_type = NGTCP2_TOKEN_TYPE_RETRY;
+				
 				params.original_dcid = *ocid;
+				params.original_dcid_present = 1;
 				params.retry_scid = packet_header.dcid;
 				params.retry_scid_present = 1;
 			} else {
+				// The dispatcher only passes on tokens it has validated:
+				if (packet_header.tokenlen) {
+					settings.token_type = NGTCP2_TOKEN_TYPE_NEW_TOKEN;
+				}
+				
 				params.original_dcid = packet_header.dcid;
 				params.original_dcid_present = 1;
 			}
 			
 			auto path = ngtcp2_path{
-				.local = socket.local_address(),
+				.local = local_address,
 				.remote = remote_address,
 				.user_data = &socket,
 			};
@@ -66,6 +84,10 @@ namespace Protocol
 			setup(tls_context, &packet_header.scid, &_scid, &path, packet_header.version, &settings, &params);
 		}
 		
+		Server::Server(Dispatcher & binding, Configuration & configuration, TLS::ServerContext & tls_context, Socket & socket, const Address & remote_address, const ngtcp2_pkt_hd & packet_header, ngtcp2_cid *ocid) : Server(binding, configuration, tls_context, socket, socket.local_address(), remote_address, packet_header, ocid)
+		{
+		}
+		
 		Server::~Server()
 		{
 		}
@@ -75,10 +97,19 @@ namespace Protocol
 			_dispatcher.remove(this);
 		}
 		
-		void Server::process_packet(Socket & socket, const Address & remote_address, const Byte *data, std::size_t length, ECN ecn)
+		void Server::generate_cid(ngtcp2_cid *cid, std::size_t length)
+		{
+			if (auto & generator = _configuration.connection_id_generator) {
+				generator->generate(cid, _dispatcher.worker(), _dispatcher.workers());
+			} else {
+				Connection::generate_cid(cid, length);
+			}
+		}
+		
+		void Server::process_packet(Socket & socket, const Address & local_address, const Address & remote_address, const Byte *data, std::size_t length, ECN ecn, std::uint64_t receive_time)
 		{
 			auto path = ngtcp2_path{
-				.local = socket.local_address(),
+				.local = local_address,
 				.remote = remote_address,
 				.user_data = &socket,
 			};
@@ -87,7 +118,7 @@ namespace Protocol
 				.ecn = static_cast<uint8_t>(ecn),
 			};
 			
-			auto result = ngtcp2_conn_read_pkt(_connection, &path, &packet_info, data, length, timestamp());
+			auto result = ngtcp2_conn_read_pkt(_connection, &path, &packet_info, data, length, receive_timestamp(receive_time));
 			
 			_received_packets.release();
 			
@@ -106,6 +137,95 @@ namespace Protocol
 			disconnect();
 		}
 		
+		void Server::handshake_completed()
+		{
+			Connection::handshake_completed();
+			
+			if (_configuration.new_tokens) {
+				submit_new_token();
+			}
+			
+			if (_configuration.connected_sockets) {
+				connect_socket();
+			}
+		}
+		
+		void Server::submit_new_token()
+		{
+			auto path = ngtcp2_conn_get_path(_connection);
+			auto & static_secret = _configuration.static_secret;
+			std::array<std::uint8_t, NGTCP2_CRYPTO_MAX_REGULAR_TOKENLEN> token;
+			
+			auto length = ngtcp2_crypto_generate_regular_token(token.data(), static_secret.data(), static_secret.size(), path->remote.addr, path->remote.addrlen, timestamp());
+			
+			if (length < 0) {
+				throw std::runtime_error("Failed to generate address validation token!");
+			}
+			
+			if (auto result = ngtcp2_conn_submit_new_token(_connection, token.data(), length)) {
+				throw std::runtime_error(std::string("Failed to submit address validation token: ") + ngtcp2_strerror(result));
+			}
+		}
+		
+		bool Server::connect_socket()
+		{
+			auto path = ngtcp2_conn_get_path(_connection);
+			Address local_address(path->local), remote_address(path->remote);
+			
+			auto socket = std::make_unique<Socket>(local_address.family());
+			socket->annotate("connected to " + remote_address.to_string());
+			
+			// The local address may be an IPv4-mapped address, if the listening socket is dual-stack:
+			if (local_address.family() == AF_INET6) {
+				socket->set_dual_stack(true);
+			}
+			
+			// Between binding and connecting, the socket may receive packets for other connections, which are handed back to the dispatcher by `redirect_packet`:
+			socket->set_reuse_port(true);
+			
+			// If the socket can't be connected, the connection keeps using the listening socket:
+			if (!socket->bind(local_address) || !socket->connect(remote_address)) {
+				return false;
+			}
+			
+			_socket = std::move(socket);
+			ngtcp2_conn_set_path_user_data(_connection, _socket.get());
+			
+			return true;
+		}
+		
+		bool Server::redirect_packet(Socket & socket, const ReceiveBatch::Packet & packet)
+		{
+			// Packets received on the listening socket belong to this connection, even if the client migrated:
+			if (&socket != _socket.get()) return false;
+			
+			_dispatcher.redirect_packet(_listening_socket, packet.local_address, packet.remote_address, packet.data, packet.size, packet.ecn, packet.receive_time);
+			
+			return true;
+		}
+		
+		Connection::Status Server::receive_packets()
+		{
+			// If the socket is backlogged, wait for it to catch up before writing more packets:
+			if (_socket->backlogged()) {
+				if (flush_transmit_queue()) {
+					send_packets();
+				} else {
+					handle_expiry();
+				}
+			}
+			
+			ngtcp2_path_storage path_storage;
+			ngtcp2_path_storage_zero(&path_storage);
+			ngtcp2_path_copy(&path_storage.path, ngtcp2_conn_get_path(_connection));
+			
+			auto status = Connection::receive_packets(path_storage.path, *_socket);
+			
+			if (status != Status::OK) return status;
+			
+			return send_packets();
+		}
+		
 		void Server::drain()
 		{
 			auto duration = close_duration();
@@ -120,6 +240,18 @@ namespace Protocol
 		void Server::accept()
 		{
 			while (true) {
+				// Once connected, packets are received directly from the connection's socket:
+				if (_socket) {
+					Status status = receive_packets();
+					
+					if (status == Status::DRAINING || status == Status::CLOSING) {
+						drain();
+						return;
+					}
+					
+					continue;
+				}
+				
 				bool result = _received_packets.acquire(extract_optional(expiry_timeout()));
 				
 				if (result) {
@@ -140,6 +272,11 @@ namespace Protocol
 						return;
 					}
 				}
+				
+				// The listening socket is shared with other servers, so the dispatcher lets this server continue once it has caught up:
+				if (backlogged()) {
+					_dispatcher.wait_writable(this);
+				}
 			}
 		}
 		
@@ -27,25 +27,63 @@ namespace Protocol
 		// Each Server instance is associated with a single QUIC connection and a remote Client instance.
 		class Server : public Connection
 		{
+			friend class Dispatcher;
+			
 			void setup(TLS::ServerContext & tls_context, const ngtcp2_cid *dcid, const ngtcp2_cid *scid, const ngtcp2_path *path, uint32_t client_chosen_version, ngtcp2_settings *settings, ngtcp2_transport_params *params, const ngtcp2_mem *mem = nullptr);
 		public:
+			// @parameter ocid the original destination connection ID, recovered from the client's Retry token, if its address was validated by a Retry packet (see `Dispatcher::send_retry`).
+			Server(Dispatcher & binding, Configuration & configuration, TLS::ServerContext & tls_context, Socket & socket, const Address & local_address, const Address & remote_address, const ngtcp2_pkt_hd & packet_header, ngtcp2_cid *ocid = nullptr);
+			
+			// Create a server using the socket's local address, see `Dispatcher::create_server`.
 			Server(Dispatcher & binding, Configuration & configuration, TLS::ServerContext & tls_context, Socket & socket, const Address & remote_address, const ngtcp2_pkt_hd & packet_header, ngtcp2_cid *ocid = nullptr);
+			
 			virtual ~Server();
 			
 			void disconnect() override;
 			
-			void process_packet(Socket & socket, const Address & remote_address, const Byte *data, std::size_t length, ECN ecn);
+			// Generate connection IDs using `Configuration::connection_id_generator`, which encodes the index of the owning worker in a sharded server, see `Distributor`.
+			void generate_cid(ngtcp2_cid *cid, std::size_t length = DEFAULT_SCID_LENGTH) override;
+			
+			// @parameter local_address the address the packet was received on, which may be more specific than the address the socket is bound to.
+			// @parameter receive_time the time at which the kernel received the packet, see `ReceiveBatch::Packet::receive_time`.
+			void process_packet(Socket & socket, const Address & local_address, const Address & remote_address, const Byte *data, std::size_t length, ECN ecn, std::uint64_t receive_time = 0);
 			
 			void accept();
 			
+			// Issue an address validation token if enabled by `Configuration::new_tokens`, and move the connection to its own connected socket, if enabled by `Configuration::connected_sockets`. Sub-classes which override this must invoke it.
+			void handshake_completed() override;
+			
+			// Issue an address validation token bound to the client's address, which it can present when it reconnects, see `Configuration::new_tokens`.
+			void submit_new_token();
+			
 		protected:
 			void drain();
 			
+			// The socket connected to the client, once the handshake has completed:
+			std::unique_ptr<Socket> _socket;
+			
+			// Open a socket bound to the local address and connected to the remote address of the current path, and use it for the path.
+			// @returns whether the socket was connected.
+			bool connect_socket();
+			
+			// Receive and process packets from the connected socket, and send any packets that result.
+			using Connection::receive_packets;
+			Status receive_packets();
+			
+			// The connected socket joins the listening socket's `SO_REUSEPORT` group before it is connected, so it may receive packets for other connections, which are handed back to the dispatcher, see `Dispatcher::redirect_packet`.
+			bool redirect_packet(Socket & socket, const ReceiveBatch::Packet & packet) override;
+			
 			Dispatcher & _dispatcher;
+			
+			// The socket the connection was accepted on, which is shared with other connections:
+			Socket & _listening_socket;
 			std::unique_ptr<TLS::ServerSession> _tls_session;
 			
 			Scheduler::Semaphore _received_packets = 0;
 			
+			// Whether the dispatcher will let this server continue sending once the listening socket has caught up, see `Dispatcher::wait_writable`:
+			bool _waiting_writable = false;
+			
 			ngtcp2_cid _scid;
 			
 			void print(std::ostream & output) const override;
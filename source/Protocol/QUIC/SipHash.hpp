@@ -0,0 +1,103 @@
+//
+//  SipHash.hpp
+//  This file is part of the "Protocol::QUIC" project and released under the MIT License.
+//
+//  Created by Samuel Williams on 16/10/2026.
+//  Copyright, 2026, by Samuel Williams. All rights reserved.
+//
+
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+
+namespace Protocol
+{
+	namespace QUIC
+	{
+		// SipHash-2-4 is a fast keyed hash function for short inputs. Without the key, an attacker can't choose inputs (e.g. connection IDs) which collide, so it is safe to use for hash tables indexed by data from the network.
+		struct SipHash {
+			std::uint64_t k0 = 0, k1 = 0;
+			
+			// Hash a buffer of any length.
+			std::uint64_t operator()(const void * data, std::size_t length) const noexcept
+			{
+				return hash(data, length);
+			}
+			
+			// Hash a buffer of a length known at compile time, so that the compression rounds and the final block are fully unrolled.
+			template <std::size_t LENGTH>
+			std::uint64_t hash(const void * data) const noexcept
+			{
+				return hash(data, LENGTH);
+			}
+			
+			inline std::uint64_t hash(const void * data, std::size_t length) const noexcept
+			{
+				auto input = static_cast<const std::uint8_t *>(data);
+				
+				std::uint64_t v0 = k0 ^ 0x736f6d6570736575ULL;
+				std::uint64_t v1 = k1 ^ 0x646f72616e646f6dULL;
+				std::uint64_t v2 = k0 ^ 0x6c7967656e657261ULL;
+				std::uint64_t v3 = k1 ^ 0x7465646279746573ULL;
+				
+				auto round = [&]{
+					v0 += v1; v1 = rotate(v1, 13); v1 ^= v0; v0 = rotate(v0, 32);
+					v2 += v3; v3 = rotate(v3, 16); v3 ^= v2;
+					v0 += v3; v3 = rotate(v3, 21); v3 ^= v0;
+					v2 += v1; v1 = rotate(v1, 17); v1 ^= v2; v2 = rotate(v2, 32);
+				};
+				
+				auto end = input + (length & ~std::size_t(7));
+				
+				for (; input != end; input += 8) {
+					auto m = load(input);
+					
+					v3 ^= m;
+					round(); round();
+					v0 ^= m;
+				}
+				
+				// The final block holds the remaining bytes and the length in the most significant byte:
+				std::uint64_t b = static_cast<std::uint64_t>(length) << 56;
+				
+				for (std::size_t index = 0; index < (length & 7); index += 1) {
+					b |= static_cast<std::uint64_t>(input[index]) << (8 * index);
+				}
+				
+				v3 ^= b;
+				round(); round();
+				v0 ^= b;
+				
+				v2 ^= 0xff;
+				round(); round(); round(); round();
+				
+				return v0 ^ v1 ^ v2 ^ v3;
+			}
+			
+		private:
+			static std::uint64_t rotate(std::uint64_t value, int bits) noexcept
+			{
+				return (value << bits) | (value >> (64 - bits));
+			}
+			
+			// Load a little endian 64-bit word.
+			static std::uint64_t load(const std::uint8_t * input) noexcept
+			{
+#if __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+				std::uint64_t value;
+				std::memcpy(&value, input, sizeof(value));
+				return value;
+#else
+				std::uint64_t value = 0;
+				
+				for (std::size_t index = 0; index < 8; index += 1) {
+					value |= static_cast<std::uint64_t>(input[index]) << (8 * index);
+				}
+				
+				return value;
+#endif
+			}
+		};
+	}
+}
@@ -6,10 +6,18 @@
 //  Copyright, 2023, by Samuel Williams. All rights reserved.
 //
 
+// This is required for IPV6_RECVPKTINFO on macOS.
+#define __APPLE_USE_RFC_3542
+
 #include "Socket.hpp"
+#include "ReceiveBatch.hpp"
+#include "TransmitBatch.hpp"
+#include "Ring.hpp"
 #include "Defer.hpp"
 
 #include <cstring>
+#include <algorithm>
+#include <stdexcept>
 #include <system_error>
 #include <iostream>
 
@@ -17,9 +25,16 @@
 #include <sys/types.h>
 #include <sys/socket.h>
 #include <netinet/in.h>
-
-#ifndef SOCK_NONBLOCK
+#include <netinet/udp.h>
+#include <sys/ioctl.h>
+#include <time.h>
 #include <fcntl.h>
+
+#if defined(__linux__)
+#include <linux/errqueue.h>
+#include <linux/net_tstamp.h>
+#include <linux/sock_diag.h>
+#include <linux/filter.h>
 #endif
 
 namespace Protocol
@@ -35,12 +50,53 @@ namespace Protocol
 			case AF_INET:
 				return setsockopt(descriptor, IPPROTO_IP, IP_RECVTOS, &tos, static_cast<socklen_t>(sizeof(tos)));
 			case AF_INET6:
+				// IPv4 packets received by a dual-stack socket only carry IP level control messages. This fails harmlessly where it's unsupported:
+				setsockopt(descriptor, IPPROTO_IP, IP_RECVTOS, &tos, static_cast<socklen_t>(sizeof(tos)));
+				
 				return setsockopt(descriptor, IPPROTO_IPV6, IPV6_RECVTCLASS, &tos, static_cast<socklen_t>(sizeof(tos)));
 			}
 			
 			return 0;
 		}
 		
+		// Report the local (destination) address of each received packet, which is needed to reply from the correct address when bound to a wildcard address.
+		int set_receive_packet_info(int descriptor, int family) {
+			int value = 1;
+			
+			switch (family) {
+			case AF_INET:
+				return setsockopt(descriptor, IPPROTO_IP, IP_PKTINFO, &value, static_cast<socklen_t>(sizeof(value)));
+			case AF_INET6:
+				return setsockopt(descriptor, IPPROTO_IPV6, IPV6_RECVPKTINFO, &value, static_cast<socklen_t>(sizeof(value)));
+			}
+			
+			return 0;
+		}
+		
+		// Supported on Linux.
+		// Record the time at which each packet was received by the kernel, before it waited in the socket's queue.
+		int set_receive_timestamps(int descriptor) {
+#if defined(SO_TIMESTAMPNS)
+			int value = 1;
+			
+			return setsockopt(descriptor, SOL_SOCKET, SO_TIMESTAMPNS, &value, static_cast<socklen_t>(sizeof(value)));
+#endif
+			
+			return 0;
+		}
+		
+		// Supported on Linux.
+		// Report the number of packets dropped by the kernel with each received packet.
+		int set_receive_drops(int descriptor) {
+#if defined(SO_RXQ_OVFL)
+			int value = 1;
+			
+			return setsockopt(descriptor, SOL_SOCKET, SO_RXQ_OVFL, &value, static_cast<socklen_t>(sizeof(value)));
+#endif
+			
+			return 0;
+		}
+		
 		// Supported on Linux.
 		int set_ip_mtu_discover(int descriptor, int family) {
 #if defined(IP_MTU_DISCOVER) && defined(IPV6_MTU_DISCOVER)
@@ -75,6 +131,18 @@ namespace Protocol
 			return 0;
 		}
 		
+		// Supported on Linux.
+		// Allow the kernel to coalesce received datagrams from the same flow (UDP generic receive offload).
+		int set_receive_offload(int descriptor) {
+#if defined(UDP_GRO)
+			int value = 1;
+			
+			return setsockopt(descriptor, SOL_UDP, UDP_GRO, &value, static_cast<socklen_t>(sizeof(value)));
+#endif
+			
+			return 0;
+		}
+		
 		int socket_nonblocking(int domain, int type, int protocol)
 		{
 #ifdef SOCK_NONBLOCK
@@ -103,12 +171,52 @@ namespace Protocol
 			}
 			
 			set_receive_ecn(_descriptor, domain);
+			set_receive_packet_info(_descriptor, domain);
+			set_receive_timestamps(_descriptor);
+			set_receive_drops(_descriptor);
 			set_ip_mtu_discover(_descriptor, domain);
 			set_ip_dontfrag(_descriptor, domain);
+			set_receive_offload(_descriptor);
+			
+#if defined(UDP_SEGMENT)
+			_segmentation_offload = true;
+#endif
+		}
+		
+		Socket::Socket(Descriptor descriptor) :
+			_descriptor(descriptor.value),
+			_monitor(_descriptor)
+		{
+		}
+		
+		Socket Socket::duplicate() const
+		{
+			int descriptor = fcntl(_descriptor, F_DUPFD_CLOEXEC, 0);
+			
+			if (descriptor < 0) {
+				throw std::system_error(errno, std::generic_category(), "fcntl");
+			}
+			
+			Socket socket(Descriptor{descriptor});
+			
+			socket._local_address = _local_address;
+			socket._remote_address = _remote_address;
+			socket._dscp = _dscp;
+			socket._wildcard = _wildcard;
+			socket._reuse_port_steering = _reuse_port_steering;
+			socket._segmentation_offload = _segmentation_offload;
+			socket._transmit_time = _transmit_time;
+			socket._transmit_time_unsupported = _transmit_time_unsupported;
+			socket._transmit_queue_capacity = _transmit_queue_capacity;
+			
+			return socket;
 		}
 		
 		void Socket::close()
 		{
+			// The ring must be closed first, as it may still be using the descriptor:
+			_ring.reset();
+			
 			if (_descriptor >= 0) {
 				auto result = ::close(_descriptor);
 				
@@ -127,11 +235,37 @@ namespace Protocol
 		
 		Socket::Socket(Socket && other) :
 			_descriptor(other._descriptor),
-			_monitor(std::move(other._monitor))
+			_monitor(std::move(other._monitor)),
+			_dscp(other._dscp),
+			_statistics(other._statistics),
+			_receive_buffer_limit(other._receive_buffer_limit),
+			_busy_poll_budget(other._busy_poll_budget),
+			_busy(other._busy),
+			_wildcard(other._wildcard),
+			_reuse_port_steering(other._reuse_port_steering),
+			_segmentation_offload(other._segmentation_offload),
+			_transmit_time(other._transmit_time),
+			_transmit_time_unsupported(other._transmit_time_unsupported),
+			_transmit_queue(std::move(other._transmit_queue)),
+			_transmit_queue_capacity(other._transmit_queue_capacity),
+			_transmit_batch(std::move(other._transmit_batch)),
+			_hold_count(other._hold_count),
+			_receive_batch(std::move(other._receive_batch)),
+			_ring(std::move(other._ring)),
+			_buffer_pool(std::move(other._buffer_pool)),
+			_zero_copy(other._zero_copy),
+			_zero_copy_threshold(other._zero_copy_threshold),
+			_zero_copy_sequence(other._zero_copy_sequence),
+			_zero_copy_pending(std::move(other._zero_copy_pending))
 		{
 			_local_address = other._local_address;
 			_remote_address = other._remote_address;
 			other._descriptor = -1;
+			other._hold_count = 0;
+			
+			// The zero-copy buffers belong to the descriptor's error queue, so they move with it:
+			other._zero_copy = false;
+			other._zero_copy_pending.clear();
 		}
 		
 		Socket & Socket::operator=(Socket && other)
@@ -142,10 +276,51 @@ namespace Protocol
 			_monitor = std::move(other._monitor);
 			_local_address = other._local_address;
 			_remote_address = other._remote_address;
+			_dscp = other._dscp;
+			_statistics = other._statistics;
+			_receive_buffer_limit = other._receive_buffer_limit;
+			_busy_poll_budget = other._busy_poll_budget;
+			_busy = other._busy;
+			_wildcard = other._wildcard;
+			_reuse_port_steering = other._reuse_port_steering;
+			_segmentation_offload = other._segmentation_offload;
+			_transmit_time = other._transmit_time;
+			_transmit_time_unsupported = other._transmit_time_unsupported;
+			_transmit_queue = std::move(other._transmit_queue);
+			_transmit_queue_capacity = other._transmit_queue_capacity;
+			_transmit_batch = std::move(other._transmit_batch);
+			_hold_count = other._hold_count;
+			_receive_batch = std::move(other._receive_batch);
+			_ring = std::move(other._ring);
+			_buffer_pool = std::move(other._buffer_pool);
+			_zero_copy = other._zero_copy;
+			_zero_copy_threshold = other._zero_copy_threshold;
+			_zero_copy_sequence = other._zero_copy_sequence;
+			_zero_copy_pending = std::move(other._zero_copy_pending);
 			other._descriptor = -1;
+			other._hold_count = 0;
+			other._zero_copy = false;
+			other._zero_copy_pending.clear();
 			return *this;
 		}
 		
+		Socket::Backend Socket::set_backend(Backend backend)
+		{
+			if (backend == Backend::RING && !_ring) {
+				try {
+					_ring = std::make_unique<Ring>(_descriptor);
+				} catch (const std::system_error & error) {
+					// io_uring is not available (e.g. it's disabled, or the kernel is too old), so keep using readiness:
+					if (DEBUG) std::cerr << *this << " set_backend: " << error.what() << std::endl;
+				}
+			}
+			else if (backend == Backend::READINESS) {
+				_ring.reset();
+			}
+			
+			return this->backend();
+		}
+		
 		Scheduler::Monitor & Socket::monitor()
 		{
 			return _monitor;
@@ -187,6 +362,67 @@ namespace Protocol
 			return _remote_address;
 		}
 		
+		bool Socket::set_dual_stack(bool enabled)
+		{
+			int value = enabled ? 0 : 1;
+			
+			return setsockopt(_descriptor, IPPROTO_IPV6, IPV6_V6ONLY, &value, static_cast<socklen_t>(sizeof(value))) == 0;
+		}
+		
+		bool Socket::set_reuse_port(bool enabled)
+		{
+#if defined(SO_REUSEPORT)
+			int value = enabled;
+			
+			return setsockopt(_descriptor, SOL_SOCKET, SO_REUSEPORT, &value, static_cast<socklen_t>(sizeof(value))) == 0 && enabled;
+#endif
+			
+			return false;
+		}
+		
+		// Supported on Linux.
+		// Attach a program to the reuse port group which selects a socket using a byte of the destination connection ID of short header packets.
+		int attach_reuse_port_program(int descriptor, std::uint32_t sockets, std::uint32_t offset) {
+#if defined(SO_ATTACH_REUSEPORT_CBPF)
+			// The program is run with the UDP payload at offset 0, and returns the index of the socket. Indexes outside the group fall back to the kernel's hash:
+			sock_filter code[] = {
+				// The header form is the most significant bit of the first byte:
+				BPF_STMT(BPF_LD | BPF_B | BPF_ABS, 0),
+				BPF_JUMP(BPF_JMP | BPF_JSET | BPF_K, 0x80, 0, 1),
+				BPF_STMT(BPF_RET | BPF_K, 0xffffffff),
+				
+				// Short header packets are followed by the destination connection ID:
+				BPF_STMT(BPF_LD | BPF_B | BPF_ABS, 1 + offset),
+				BPF_STMT(BPF_ALU | BPF_MOD | BPF_K, sockets),
+				BPF_STMT(BPF_RET | BPF_A, 0),
+			};
+			
+			sock_fprog program = {
+				.len = sizeof(code) / sizeof(code[0]),
+				.filter = code,
+			};
+			
+			return setsockopt(descriptor, SOL_SOCKET, SO_ATTACH_REUSEPORT_CBPF, &program, static_cast<socklen_t>(sizeof(program)));
+#endif
+			
+			errno = ENOTSUP;
+			return -1;
+		}
+		
+		bool Socket::set_reuse_port_steering(std::size_t sockets, std::size_t worker_offset)
+		{
+			if (sockets == 0 || sockets > 256 || worker_offset >= NGTCP2_MAX_CIDLEN) return false;
+			
+			if (attach_reuse_port_program(_descriptor, sockets, worker_offset) == -1) {
+				if (DEBUG) std::cerr << *this << " set_reuse_port_steering: " << std::strerror(errno) << std::endl;
+				return false;
+			}
+			
+			_reuse_port_steering = true;
+			
+			return true;
+		}
+		
 		bool Socket::bind(const Address & address)
 		{
 			// Enable address reuse for multiple binds on the same address
@@ -211,6 +447,8 @@ namespace Protocol
 				_local_address = address;
 			}
 			
+			_wildcard = address.unspecified();
+			
 			return true;
 		}
 	
@@ -238,55 +476,192 @@ namespace Protocol
 			return static_cast<ECN>(data[0] & 0x03);
 		}
 		
-		ECN get_ecn(msghdr * message, int family) {
-			switch (family) {
-			case AF_INET:
-				for (auto cmsg = CMSG_FIRSTHDR(message); cmsg; cmsg = CMSG_NXTHDR(message, cmsg)) {
-					if (cmsg->cmsg_level == IPPROTO_IP && cmsg->cmsg_type == IP_TOS && cmsg->cmsg_len) {
-						return read_ecn(CMSG_DATA(cmsg));
-					}
+		// The codepoint is read from either control message, whatever the family of the address: IPv4 packets received by a dual-stack socket have an IPv4-mapped address, but carry `IP_TOS`.
+		ECN get_ecn(msghdr * message) {
+			for (auto cmsg = CMSG_FIRSTHDR(message); cmsg; cmsg = CMSG_NXTHDR(message, cmsg)) {
+				if (cmsg->cmsg_level == IPPROTO_IP && cmsg->cmsg_type == IP_TOS && cmsg->cmsg_len) {
+					return read_ecn(CMSG_DATA(cmsg));
 				}
-				break;
-			case AF_INET6:
-				for (auto cmsg = CMSG_FIRSTHDR(message); cmsg; cmsg = CMSG_NXTHDR(message, cmsg)) {
-					if (cmsg->cmsg_level == IPPROTO_IPV6 && cmsg->cmsg_type == IPV6_TCLASS && cmsg->cmsg_len) {
-						return read_ecn(CMSG_DATA(cmsg));
-					}
+				
+				if (cmsg->cmsg_level == IPPROTO_IPV6 && cmsg->cmsg_type == IPV6_TCLASS && cmsg->cmsg_len) {
+					return read_ecn(CMSG_DATA(cmsg));
 				}
-				break;
 			}
 			
 			return ECN::UNSPECIFIED;
 		}
 		
-		int set_ecn(int descriptor, int family, ECN ecn) {
-			int tos = static_cast<unsigned int>(ecn);
+		// Supported on Linux.
+		// @returns the size of the segments which were coalesced into the received datagram, or 0 if it was not coalesced.
+		std::size_t get_segment_size(msghdr * message) {
+#if defined(UDP_GRO)
+			for (auto cmsg = CMSG_FIRSTHDR(message); cmsg; cmsg = CMSG_NXTHDR(message, cmsg)) {
+				if (cmsg->cmsg_level == SOL_UDP && cmsg->cmsg_type == UDP_GRO && cmsg->cmsg_len) {
+					int segment_size = 0;
+					std::memcpy(&segment_size, CMSG_DATA(cmsg), sizeof(segment_size));
+					
+					return segment_size;
+				}
+			}
+#endif
 			
-			switch (family) {
+			return 0;
+		}
+		
+		// Supported on Linux.
+		// @returns the time at which the kernel received the datagram, in nanoseconds on the real time clock, or 0 if it's not known.
+		std::uint64_t get_receive_time(msghdr * message) {
+#if defined(SCM_TIMESTAMPNS)
+			for (auto cmsg = CMSG_FIRSTHDR(message); cmsg; cmsg = CMSG_NXTHDR(message, cmsg)) {
+				if (cmsg->cmsg_level == SOL_SOCKET && cmsg->cmsg_type == SCM_TIMESTAMPNS && cmsg->cmsg_len) {
+					timespec time;
+					std::memcpy(&time, CMSG_DATA(cmsg), sizeof(time));
+					
+					return time.tv_sec * 1000000000ull + time.tv_nsec;
+				}
+			}
+#endif
+			
+			return 0;
+		}
+		
+		// Supported on Linux.
+		// @returns the cumulative number of packets dropped by the socket, or -1 if it's not known.
+		std::int64_t get_drops(msghdr * message) {
+#if defined(SO_RXQ_OVFL)
+			for (auto cmsg = CMSG_FIRSTHDR(message); cmsg; cmsg = CMSG_NXTHDR(message, cmsg)) {
+				if (cmsg->cmsg_level == SOL_SOCKET && cmsg->cmsg_type == SO_RXQ_OVFL && cmsg->cmsg_len) {
+					std::uint32_t drops = 0;
+					std::memcpy(&drops, CMSG_DATA(cmsg), sizeof(drops));
+					
+					return drops;
+				}
+			}
+#endif
+			
+			return -1;
+		}
+		
+		std::uint64_t clock_nanoseconds(clockid_t clock)
+		{
+			timespec time;
+			clock_gettime(clock, &time);
+			
+			return time.tv_sec * 1000000000ull + time.tv_nsec;
+		}
+		
+		// Append a control message to the message's control buffer, which must have enough space reserved. The message's `msg_controllen` is the number of bytes in use.
+		template <typename Type>
+		void append_control(msghdr & message, int level, int type, const Type & value)
+		{
+			auto cmsg = reinterpret_cast<cmsghdr *>(static_cast<Byte *>(message.msg_control) + message.msg_controllen);
+			
+			cmsg->cmsg_level = level;
+			cmsg->cmsg_type = type;
+			cmsg->cmsg_len = CMSG_LEN(sizeof(value));
+			std::memcpy(CMSG_DATA(cmsg), &value, sizeof(value));
+			
+			message.msg_controllen += CMSG_SPACE(sizeof(value));
+		}
+		
+		// Set the traffic class (DSCP and ECN codepoints) of an individual packet, rather than of the whole socket.
+		void set_traffic_class(msghdr & message, const sockaddr * destination, std::uint8_t dscp, ECN ecn)
+		{
+			int traffic_class = (dscp << 2) | static_cast<int>(ecn);
+			
+			// The socket's default traffic class is zero, so there is nothing to add:
+			if (traffic_class == 0) return;
+			
+			switch (destination->sa_family) {
 			case AF_INET:
-				return setsockopt(descriptor, IPPROTO_IP, IP_TOS, &tos, static_cast<socklen_t>(sizeof(ecn)));
+				append_control(message, IPPROTO_IP, IP_TOS, traffic_class);
+				break;
 			case AF_INET6:
-				return setsockopt(descriptor, IPPROTO_IPV6, IPV6_TCLASS, &tos, static_cast<socklen_t>(sizeof(ecn)));
+				// Packets to IPv4-mapped addresses are sent by the IPv4 output path, which ignores `IPV6_TCLASS`:
+				if (IN6_IS_ADDR_V4MAPPED(&reinterpret_cast<const sockaddr_in6 *>(destination)->sin6_addr)) {
+					append_control(message, IPPROTO_IP, IP_TOS, traffic_class);
+				} else {
+					append_control(message, IPPROTO_IPV6, IPV6_TCLASS, traffic_class);
+				}
+				break;
 			}
+		}
+		
+		// Set the local address an individual packet is sent from.
+		void set_source(msghdr & message, const Destination & source)
+		{
+			Address address(source);
 			
-			return 0;
+			switch (address.family()) {
+			case AF_INET: {
+				in_pktinfo info{};
+				info.ipi_spec_dst = address.data.in.sin_addr;
+				append_control(message, IPPROTO_IP, IP_PKTINFO, info);
+				break;
+			}
+			case AF_INET6: {
+				in6_pktinfo info{};
+				info.ipi6_addr = address.data.in6.sin6_addr;
+				append_control(message, IPPROTO_IPV6, IPV6_PKTINFO, info);
+				break;
+			}
+			}
+		}
+		
+		// Supported on Linux.
+		// Ask the kernel to split the payload into datagrams of the given size (UDP generic segmentation offload).
+		void set_segment_size(msghdr & message, std::size_t segment_size)
+		{
+#if defined(UDP_SEGMENT)
+			append_control(message, SOL_UDP, UDP_SEGMENT, static_cast<std::uint16_t>(segment_size));
+#endif
+		}
+		
+		// Supported on Linux.
+		// Set the time at which the kernel should send the packet, if `SO_TXTIME` is enabled.
+		void set_departure_time(msghdr & message, std::uint64_t departure_time)
+		{
+#if defined(SCM_TXTIME)
+			append_control(message, SOL_SOCKET, SCM_TXTIME, departure_time);
+#endif
 		}
 		
-		size_t Socket::send_packet(const void * data, std::size_t size, const Destination & destination, ECN ecn, const Timestamp * timeout)
+		size_t Socket::send_packet(const void * data, std::size_t size, const Destination & destination, ECN ecn, const Timestamp * timeout, std::size_t segment_size, std::uint64_t departure_time, const Destination * source)
 		{
 			if (DEBUG) std::cerr << *this << " send_packet " << size << " bytes to " << destination << std::endl;
 			
+			// A single segment does not need to be segmented:
+			if (segment_size >= size) segment_size = 0;
+			
+			if (_hold_count) {
+				if (!_transmit_batch->append(data, size, destination, ecn, segment_size, departure_time, source)) {
+					// The batch is full, so send what we have so far:
+					send_packets(*_transmit_batch, timeout);
+					
+					if (!_transmit_batch->append(data, size, destination, ecn, segment_size, departure_time, source)) {
+						throw std::length_error("Packet is too large for transmit batch!");
+					}
+				}
+				
+				return size;
+			}
+			
+			return transmit(data, size, destination, ecn, timeout, segment_size, departure_time, source);
+		}
+		
+		ssize_t Socket::send_message(const void * data, std::size_t size, const Destination & destination, ECN ecn, std::size_t segment_size, std::uint64_t departure_time, const Destination * source, int flags)
+		{
 			iovec iov{
 				.iov_base = const_cast<void *>(data),
 				.iov_len = size
 			};
 			
-			msghdr message{
-				.msg_name = nullptr,
-				.msg_namelen = 0,
-				.msg_iov = &iov,
-				.msg_iovlen = 1
-			};
+			alignas(cmsghdr) Byte control[TransmitBatch::CONTROL_SIZE];
+			
+			msghdr message{};
+			message.msg_iov = &iov;
+			message.msg_iovlen = 1;
+			message.msg_control = control;
 			
 			if (_remote_address) {
 				// Already connected...
@@ -298,22 +673,72 @@ namespace Protocol
 				message.msg_namelen = destination.addrlen;
 			}
 			
-			if (ecn != _ecn) {
-				set_ecn(_descriptor, destination.addr->sa_family, ecn);
+			set_traffic_class(message, destination.addr, _dscp, ecn);
+			
+			if (segment_size) {
+				set_segment_size(message, segment_size);
+			}
+			
+			if (departure_time && _transmit_time) {
+				set_departure_time(message, departure_time);
+			}
+			
+			if (source && _wildcard) {
+				set_source(message, *source);
+			}
+			
+			if (message.msg_controllen == 0) {
+				message.msg_control = nullptr;
+			}
+			
+			if (_ring) {
+				Message ring_message{message, 0};
+				
+				return _ring->send(&ring_message, 1) == 1 ? ring_message.msg_len : -1;
+			}
+			
+			return sendmsg(_descriptor, &message, flags);
+		}
+		
+		size_t Socket::transmit(const void * data, std::size_t size, const Destination & destination, ECN ecn, const Timestamp * timeout, std::size_t segment_size, std::uint64_t departure_time, const Destination * source)
+		{
+			// Packets must not overtake those which are already queued:
+			while (!transmit_queue()) {
+				if (queue_packet(data, size, destination, ecn, segment_size, departure_time, source)) {
+					return size;
+				}
+				
+				if (!monitor().wait_writable(timeout)) {
+					return 0;
+				}
+			}
+			
+			if (segment_size && !_segmentation_offload) {
+				return transmit_segments(data, size, destination, ecn, timeout, segment_size, departure_time, source);
 			}
 			
 			ssize_t result;
 			
 			do {
-				result = sendmsg(_descriptor, &message, 0);
+				result = send_message(data, size, destination, ecn, segment_size, departure_time, source);
 				
 				if (result == -1) {
 					if (errno == EAGAIN || errno == EWOULDBLOCK) {
+						// Rather than waiting for the socket to become writable, queue the packet if possible:
+						if (queue_packet(data, size, destination, ecn, segment_size, departure_time, source)) {
+							return size;
+						}
+						
 						if (!monitor().wait_writable(timeout)) {
 							return 0;
 						}
 					} else if (errno == EINTR) {
 						// ignore
+					} else if (errno == EIO && segment_size) {
+						// The network device can't segment the packet, so stop using segmentation offload on this socket:
+						_segmentation_offload = false;
+						
+						return transmit_segments(data, size, destination, ecn, timeout, segment_size, departure_time, source);
 					} else {
 						throw std::system_error(errno, std::generic_category(), "sendmsg");
 					}
@@ -322,57 +747,729 @@ namespace Protocol
 			
 			return result;
 		}
+		
+		size_t Socket::transmit_segments(const void * data, std::size_t size, const Destination & destination, ECN ecn, const Timestamp * timeout, std::size_t segment_size, std::uint64_t departure_time, const Destination * source)
+		{
+			auto bytes = static_cast<const Byte *>(data);
+			
+			for (std::size_t offset = 0; offset < size; offset += segment_size) {
+				auto length = std::min(segment_size, size - offset);
+				
+				if (!transmit(bytes + offset, length, destination, ecn, timeout, 0, departure_time, source)) {
+					return 0;
+				}
+			}
+			
+			return size;
+		}
+		
+		size_t Socket::send_buffer(BufferPool::Buffer buffer, std::size_t size, const Destination & destination, ECN ecn, const Timestamp * timeout, std::size_t segment_size, std::uint64_t departure_time, const Destination * source)
+		{
+			release_zero_copy_buffers();
+			
+			// Small packets are cheaper to copy than to track, and held packets are copied into the transmit batch anyway:
+			if (!_zero_copy || size < _zero_copy_threshold || _hold_count || _ring || (segment_size && !_segmentation_offload) || !transmit_queue()) {
+				auto result = send_packet(buffer.get(), size, destination, ecn, timeout, segment_size, departure_time, source);
+				_buffer_pool.release(std::move(buffer));
+				
+				return result;
+			}
+			
+			if (DEBUG) std::cerr << *this << " send_buffer " << size << " bytes to " << destination << " (zero copy)" << std::endl;
+			
+			if (segment_size >= size) segment_size = 0;
 
-		size_t Socket::receive_packet(void *data, std::size_t size, Address &address, ECN &ecn, const Timestamp * timeout)
+#if defined(MSG_ZEROCOPY)
+			while (true) {
+				auto result = send_message(buffer.get(), size, destination, ecn, segment_size, departure_time, source, MSG_ZEROCOPY);
+				
+				if (result >= 0) {
+					// The kernel references the buffer until it reports the completion on the error queue:
+					_zero_copy_pending.emplace_back(_zero_copy_sequence++, std::move(buffer));
+					
+					return result;
+				}
+				
+				if (errno == EAGAIN || errno == EWOULDBLOCK) {
+					// Fall back to copying, so the packet can be queued:
+					if (_transmit_queue_capacity) break;
+					
+					if (!monitor().wait_writable(timeout)) {
+						_buffer_pool.release(std::move(buffer));
+						return 0;
+					}
+				} else if (errno == EINTR) {
+					// ignore
+				} else {
+					// Fall back to copying, e.g. if the kernel can't pin any more memory (ENOBUFS):
+					break;
+				}
+			}
+#endif
+			
+			auto result = transmit(buffer.get(), size, destination, ecn, timeout, segment_size, departure_time, source);
+			_buffer_pool.release(std::move(buffer));
+			
+			return result;
+		}
+		
+		bool Socket::set_transmit_time(bool enabled)
 		{
-			iovec iov = {
-				.iov_base = data,
-				.iov_len = size
+#if defined(SO_TXTIME)
+			sock_txtime configuration{
+				// The fq qdisc requires the monotonic clock, which is also used for ngtcp2 timestamps:
+				.clockid = CLOCK_MONOTONIC,
+				.flags = 0
 			};
 			
-			uint8_t message_control[CMSG_SPACE(sizeof(uint8_t))];
+			if (!enabled) {
+				_transmit_time = false;
+			}
+			else if (_transmit_time_unsupported) {
+				// Don't try again for every packet:
+				return false;
+			}
+			else if (setsockopt(_descriptor, SOL_SOCKET, SO_TXTIME, &configuration, static_cast<socklen_t>(sizeof(configuration))) == 0) {
+				_transmit_time = true;
+			}
+			else {
+				_transmit_time_unsupported = true;
+			}
+#endif
+			
+			return _transmit_time;
+		}
+		
+		bool Socket::set_zero_copy(bool enabled, std::size_t threshold)
+		{
+			_zero_copy_threshold = threshold;
+
+#if defined(SO_ZEROCOPY) && defined(MSG_ZEROCOPY)
+			int value = enabled;
+			
+			if (setsockopt(_descriptor, SOL_SOCKET, SO_ZEROCOPY, &value, static_cast<socklen_t>(sizeof(value))) == 0) {
+				_zero_copy = enabled;
+			} else {
+				_zero_copy = false;
+			}
+#endif
 			
-			msghdr message = {
-				// Provide the address data pointer / length:
-				.msg_name = &address.data,
-				.msg_namelen = sizeof(address.data),
+			return _zero_copy;
+		}
+		
+		void Socket::release_zero_copy_buffers()
+		{
+#if defined(SO_EE_ORIGIN_ZEROCOPY)
+			if (_zero_copy_pending.empty()) return;
+			
+			alignas(cmsghdr) Byte control[CMSG_SPACE(sizeof(sock_extended_err) + sizeof(sockaddr_in6))];
+			
+			while (true) {
+				msghdr message{};
+				message.msg_control = control;
+				message.msg_controllen = sizeof(control);
 				
-				// Provide the data buffer io vectors:
-				.msg_iov = &iov,
-				.msg_iovlen = 1,
+				if (recvmsg(_descriptor, &message, MSG_ERRQUEUE|MSG_DONTWAIT) == -1) {
+					break;
+				}
 				
-				// Provide the message control buffer (for reading the ecn):
-				.msg_control = message_control,
-				.msg_controllen = sizeof(message_control)
+				for (auto cmsg = CMSG_FIRSTHDR(&message); cmsg; cmsg = CMSG_NXTHDR(&message, cmsg)) {
+					if (!((cmsg->cmsg_level == IPPROTO_IP && cmsg->cmsg_type == IP_RECVERR) || (cmsg->cmsg_level == IPPROTO_IPV6 && cmsg->cmsg_type == IPV6_RECVERR))) continue;
+					
+					sock_extended_err error;
+					std::memcpy(&error, CMSG_DATA(cmsg), sizeof(error));
+					
+					if (error.ee_errno != 0 || error.ee_origin != SO_EE_ORIGIN_ZEROCOPY) continue;
+					
+					// The kernel had to copy the data anyway (e.g. the device doesn't support scatter-gather), so zero-copy is only adding overhead:
+					if (error.ee_code & SO_EE_CODE_ZEROCOPY_COPIED) {
+						_zero_copy = false;
+					}
+					
+					// The completed sends are the (inclusive) range of sequence numbers from ee_info to ee_data:
+					std::uint32_t first = error.ee_info, last = error.ee_data;
+					
+					for (auto iterator = _zero_copy_pending.begin(); iterator != _zero_copy_pending.end();) {
+						if (iterator->first - first <= last - first) {
+							_buffer_pool.release(std::move(iterator->second));
+							iterator = _zero_copy_pending.erase(iterator);
+						} else {
+							++iterator;
+						}
+					}
+				}
+			}
+#endif
+		}
+		
+		// Send up to count messages without blocking. Uses `sendmmsg` where available, otherwise falls back to a loop of `sendmsg`.
+		// @returns the number of messages sent, or -1 if an error occurred (errno is set).
+		int send_messages(int descriptor, Message * messages, std::size_t count)
+		{
+#if defined(__linux__)
+			return sendmmsg(descriptor, messages, count, 0);
+#else
+			std::size_t index = 0;
+			
+			for (; index < count; index += 1) {
+				auto result = sendmsg(descriptor, &messages[index].msg_hdr, 0);
+				
+				if (result == -1) {
+					// Only report the error if nothing was sent:
+					if (index == 0) return -1;
+					
+					break;
+				}
+				
+				messages[index].msg_len = result;
+			}
+			
+			return index;
+#endif
+		}
+		
+		Message * Socket::prepare_messages(TransmitBatch & batch)
+		{
+			auto messages = batch.prepare(static_cast<bool>(_remote_address));
+			auto & packets = batch._packets;
+			
+			for (std::size_t index = 0; index < batch.size(); index += 1) {
+				set_traffic_class(messages[index].msg_hdr, &packets[index].destination.data.sa, _dscp, packets[index].ecn);
+				
+				if (packets[index].segment_size) {
+					set_segment_size(messages[index].msg_hdr, packets[index].segment_size);
+				}
+				
+				if (packets[index].departure_time && _transmit_time) {
+					set_departure_time(messages[index].msg_hdr, packets[index].departure_time);
+				}
+				
+				if (packets[index].source && _wildcard) {
+					set_source(messages[index].msg_hdr, packets[index].source);
+				}
+			}
+			
+			return messages;
+		}
+		
+		std::size_t Socket::send_packets(TransmitBatch & batch, const Timestamp * timeout)
+		{
+			if (DEBUG) std::cerr << *this << " send_packets " << batch.size() << " packets" << std::endl;
+			
+			auto messages = prepare_messages(batch);
+			auto & packets = batch._packets;
+			std::size_t count = batch.size(), offset = 0;
+			
+			// Packets which need to be segmented in user space, because segmentation offload is unavailable:
+			auto segmented = [&](const TransmitBatch::Packet & packet) {
+				return packet.segment_size && !_segmentation_offload;
 			};
 			
-			ssize_t result;
+			while (offset < count) {
+				auto & packet = packets[offset];
+				
+				// Packets must not overtake those which are already queued:
+				if (!transmit_queue()) {
+					if (queue_packets(batch, offset)) {
+						offset = count;
+						break;
+					}
+					
+					if (!monitor().wait_writable(timeout)) {
+						break;
+					}
+					
+					continue;
+				}
+				
+				if (segmented(packet)) {
+					Destination source = packet.source;
+					
+					if (!transmit_segments(batch._buffer.data() + packet.offset, packet.size, packet.destination, packet.ecn, timeout, packet.segment_size, packet.departure_time, packet.source ? &source : nullptr)) {
+						break;
+					}
+					
+					offset += 1;
+					continue;
+				}
+				
+				// Send all the packets up to the next one which needs to be segmented:
+				std::size_t end = offset + 1;
+				
+				while (end < count && !segmented(packets[end])) {
+					end += 1;
+				}
+				
+				auto result = _ring ? _ring->send(messages + offset, end - offset) : send_messages(_descriptor, messages + offset, end - offset);
+				
+				if (result == -1) {
+					if (errno == EAGAIN || errno == EWOULDBLOCK) {
+						// Rather than waiting for the socket to become writable, queue the remaining packets if possible:
+						if (queue_packets(batch, offset)) {
+							offset = count;
+							break;
+						}
+						
+						if (!monitor().wait_writable(timeout)) {
+							break;
+						}
+					} else if (errno == EINTR) {
+						// ignore
+					} else if (errno == EIO && packet.segment_size) {
+						// The network device can't segment the packet, so stop using segmentation offload on this socket:
+						_segmentation_offload = false;
+					} else {
+						batch.clear();
+						throw std::system_error(errno, std::generic_category(), "sendmmsg");
+					}
+				} else {
+					offset += result;
+				}
+			}
+			
+			batch.clear();
+			
+			return offset;
+		}
+		
+		void Socket::set_transmit_queue(std::size_t capacity)
+		{
+			_transmit_queue_capacity = capacity;
+			
+			// A larger queue is allocated when it's next needed:
+			if (_transmit_queue && _transmit_queue->empty()) {
+				_transmit_queue.reset();
+			}
+		}
+		
+		bool Socket::queue_packet(const void * data, std::size_t size, const Destination & destination, ECN ecn, std::size_t segment_size, std::uint64_t departure_time, const Destination * source)
+		{
+			if (!_transmit_queue_capacity) return false;
+			
+			if (!_transmit_queue) {
+				_transmit_queue = std::make_unique<TransmitBatch>(_transmit_queue_capacity);
+			}
+			
+			auto & queue = *_transmit_queue;
+			
+			if (segment_size && !_segmentation_offload) {
+				auto bytes = static_cast<const Byte *>(data);
+				
+				if (!queue.fits((size + segment_size - 1) / segment_size, size)) return false;
+				
+				for (std::size_t offset = 0; offset < size; offset += segment_size) {
+					queue.append(bytes + offset, std::min(segment_size, size - offset), destination, ecn, 0, departure_time, source);
+				}
+				
+				return true;
+			}
+			
+			if (DEBUG) std::cerr << *this << " queue_packet " << size << " bytes to " << destination << std::endl;
+			
+			return queue.append(data, size, destination, ecn, segment_size, departure_time, source);
+		}
+		
+		bool Socket::queue_packets(TransmitBatch & batch, std::size_t offset)
+		{
+			if (!_transmit_queue_capacity) return false;
+			
+			std::size_t count = 0, size = 0;
+			
+			for (std::size_t index = offset; index < batch.size(); index += 1) {
+				auto & packet = batch._packets[index];
+				
+				count += (packet.segment_size && !_segmentation_offload) ? (packet.size + packet.segment_size - 1) / packet.segment_size : 1;
+				size += packet.size;
+			}
+			
+			if (!_transmit_queue) {
+				_transmit_queue = std::make_unique<TransmitBatch>(_transmit_queue_capacity);
+			}
+			
+			if (!_transmit_queue->fits(count, size)) return false;
+			
+			for (std::size_t index = offset; index < batch.size(); index += 1) {
+				auto & packet = batch._packets[index];
+				Destination source = packet.source;
+				
+				queue_packet(batch._buffer.data() + packet.offset, packet.size, packet.destination, packet.ecn, packet.segment_size, packet.departure_time, packet.source ? &source : nullptr);
+			}
+			
+			return true;
+		}
+		
+		bool Socket::transmit_queue()
+		{
+			if (!_transmit_queue) return true;
+			
+			auto & queue = *_transmit_queue;
+			
+			while (!queue.empty()) {
+				// Packets which were queued before segmentation offload was disabled must be split into a new queue with enough space for all the segments:
+				if (!_segmentation_offload) {
+					std::size_t count = 0;
+					
+					for (std::size_t index = 0; index < queue.size(); index += 1) {
+						auto & packet = queue._packets[index];
+						count += packet.segment_size ? (packet.size + packet.segment_size - 1) / packet.segment_size : 1;
+					}
+					
+					if (count > queue.size()) {
+						// The packets were already accepted, so they are split directly into the new queue, regardless of the current capacity (which may have been reduced, or set to zero, since they were queued):
+						auto segmented_queue = std::make_unique<TransmitBatch>(count, queue._buffer.size());
+						
+						for (std::size_t index = 0; index < queue.size(); index += 1) {
+							auto & packet = queue._packets[index];
+							auto data = queue._buffer.data() + packet.offset;
+							Destination source = packet.source;
+							
+							if (packet.segment_size) {
+								for (std::size_t offset = 0; offset < packet.size; offset += packet.segment_size) {
+									segmented_queue->append(data + offset, std::min(packet.segment_size, packet.size - offset), packet.destination, packet.ecn, 0, packet.departure_time, packet.source ? &source : nullptr);
+								}
+							} else {
+								segmented_queue->append(data, packet.size, packet.destination, packet.ecn, 0, packet.departure_time, packet.source ? &source : nullptr);
+							}
+						}
+						
+						_transmit_queue = std::move(segmented_queue);
+						
+						return transmit_queue();
+					}
+				}
+				
+				auto messages = prepare_messages(queue);
+				auto result = _ring ? _ring->send(messages, queue.size()) : send_messages(_descriptor, messages, queue.size());
+				
+				if (result == -1) {
+					if (errno == EAGAIN || errno == EWOULDBLOCK) {
+						return false;
+					} else if (errno == EINTR) {
+						// ignore
+					} else if (errno == EIO && queue._packets[0].segment_size) {
+						// The network device can't segment the packet, so stop using segmentation offload on this socket:
+						_segmentation_offload = false;
+					} else {
+						throw std::system_error(errno, std::generic_category(), "sendmmsg");
+					}
+				} else {
+					queue.consume(result);
+				}
+			}
+			
+			return true;
+		}
+		
+		bool Socket::backlogged()
+		{
+			return !transmit_queue();
+		}
+		
+		bool Socket::flush_transmit_queue(const Timestamp * timeout)
+		{
+			while (!transmit_queue()) {
+				if (!monitor().wait_writable(timeout)) {
+					return false;
+				}
+			}
+			
+			return true;
+		}
+		
+		void Socket::hold()
+		{
+			if (!_transmit_batch) {
+				_transmit_batch = std::make_unique<TransmitBatch>();
+			}
+			
+			_hold_count += 1;
+		}
+		
+		void Socket::flush(const Timestamp * timeout)
+		{
+			assert(_hold_count > 0);
+			
+			_hold_count -= 1;
+			
+			if (_hold_count == 0 && !_transmit_batch->empty()) {
+				send_packets(*_transmit_batch, timeout);
+			}
+		}
+		
+		size_t Socket::receive_packet(void *data, std::size_t size, Address &address, ECN &ecn, const Timestamp * timeout)
+		{
+			// Coalesced datagrams are received into a batch, and returned one segment at a time:
+			if (!_receive_batch) {
+				_receive_batch = std::make_unique<ReceiveBatch>(1);
+			}
+			
+			auto & batch = *_receive_batch;
+			
+			if (batch.empty()) {
+				if (!receive_packets(batch, timeout)) {
+					return 0;
+				}
+			}
+			
+			auto packet = batch.next();
+			auto result = std::min(size, packet->size);
+			
+			std::memcpy(data, packet->data, result);
+			address = packet->remote_address;
+			ecn = packet->ecn;
+			
+			if (DEBUG) std::cerr << *this << " receive_packet " << result << " bytes from " << address << std::endl;
+			
+			return result;
+		}
+		
+		// Receive up to count messages without blocking. Uses `recvmmsg` where available, otherwise falls back to a loop of `recvmsg`.
+		// @returns the number of messages received, or -1 if an error occurred (errno is set).
+		int receive_messages(int descriptor, Message * messages, std::size_t count)
+		{
+#if defined(__linux__)
+			return recvmmsg(descriptor, messages, count, 0, nullptr);
+#else
+			std::size_t index = 0;
+			
+			for (; index < count; index += 1) {
+				auto result = recvmsg(descriptor, &messages[index].msg_hdr, 0);
+				
+				if (result == -1) {
+					// Only report the error if nothing was received:
+					if (index == 0) return -1;
+					
+					break;
+				}
+				
+				messages[index].msg_len = result;
+			}
+			
+			return index;
+#endif
+		}
+		
+		std::size_t Socket::receive_packets(ReceiveBatch & batch, const Timestamp * timeout)
+		{
+			auto messages = batch.prepare();
+			
+			int result;
+			
+			auto receive = [&]{
+				return _ring ? _ring->receive(messages, batch.capacity()) : receive_messages(_descriptor, messages, batch.capacity());
+			};
+			
+			// The socket is busy if packets are already waiting, or arrive shortly after we start waiting:
+			bool busy = true;
 			
 			do {
-				result = recvmsg(_descriptor, &message, 0);
+				result = receive();
+				
+				if (result == -1 && _busy_poll_budget && _busy && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+					// Spin until a packet arrives or the budget is exhausted:
+					auto deadline = clock_nanoseconds(CLOCK_MONOTONIC) + _busy_poll_budget;
+					
+					do {
+						result = receive();
+					} while (result == -1 && (errno == EAGAIN || errno == EWOULDBLOCK) && clock_nanoseconds(CLOCK_MONOTONIC) < deadline);
+				}
 				
 				if (result == -1) {
 					if (errno == EAGAIN || errno == EWOULDBLOCK) {
-						if (!monitor().wait_readable(timeout)) {
+						// Spinning didn't find any packets (or wasn't attempted), so stop until it looks worthwhile again:
+						_busy = false;
+						
+						// Zero-copy completions make the socket readable, so they must be consumed before waiting:
+						release_zero_copy_buffers();
+						
+						// Take the opportunity to send any queued packets:
+						transmit_queue();
+						
+						// With io_uring, the completion queue becomes readable when packets have been received:
+						auto & monitor = _ring ? _ring->monitor() : this->monitor();
+						auto start = _busy_poll_budget ? clock_nanoseconds(CLOCK_MONOTONIC) : 0;
+						
+						if (!monitor.wait_readable(timeout)) {
 							return 0;
 						}
+						
+						// If the packet arrived within the budget, spinning would have received it without the wakeup:
+						busy = _busy_poll_budget && clock_nanoseconds(CLOCK_MONOTONIC) - start <= _busy_poll_budget;
 					} else if (errno == EINTR) {
 						// ignore
 					} else {
-						throw std::system_error(errno, std::generic_category(), "recvmsg");
+						throw std::system_error(errno, std::generic_category(), "recvmmsg");
 					}
 				}
 			} while (result == -1);
 			
-			// Read the ECN from the message control buffer:
-			_ecn = ecn = get_ecn(&message, address.data.sa.sa_family);
+			if (busy) _busy = true;
 			
-			// Update the address with the actual length:
-			address.length = message.msg_namelen;
+			std::size_t count = 0;
 			
-			if (DEBUG) std::cerr << *this << " receive_packet " << result << " bytes from " << address << std::endl;
+			// Kernel timestamps use the real time clock, so they are converted to the monotonic clock by measuring how long ago they were taken:
+			auto real_time = clock_nanoseconds(CLOCK_REALTIME);
+			auto monotonic_time = clock_nanoseconds(CLOCK_MONOTONIC);
 			
-			return result;
+			for (int index = 0; index < result; index += 1) {
+				auto & message = messages[index];
+				auto & packet = batch._packets[index];
+				
+				packet.size = message.msg_len;
+				
+				// Update the address with the actual length:
+				packet.remote_address.length = message.msg_hdr.msg_namelen;
+				
+				// Read the local address from the message control buffer, which is more specific than the bound address if the socket is bound to a wildcard address:
+				if (auto address = Address::extract(&message.msg_hdr, local_address().family())) {
+					packet.local_address = *address;
+					packet.local_address.set_port(this->local_address());
+				} else {
+					packet.local_address = local_address();
+				}
+				
+				// Read the ECN from the message control buffer:
+				packet.ecn = get_ecn(&message.msg_hdr);
+				
+				if (auto receive_time = get_receive_time(&message.msg_hdr)) {
+					// The real time clock may have been adjusted since the datagram was received:
+					auto age = real_time > receive_time ? real_time - receive_time : 0;
+					
+					packet.receive_time = monotonic_time - std::min(age, monotonic_time);
+				} else {
+					packet.receive_time = 0;
+				}
+				
+				// The datagram may contain several coalesced packets, which are split by `ReceiveBatch::next`:
+				packet.segment_size = get_segment_size(&message.msg_hdr);
+				
+				batch._lengths[index] = message.msg_len;
+				
+				std::size_t packets = 1;
+				
+				if (packet.segment_size) {
+					packets = (message.msg_len + packet.segment_size - 1) / packet.segment_size;
+				}
+				
+				// Coalesced packets all carry the same codepoint:
+				switch (packet.ecn) {
+				case ECN::CAPABLE_ECT_0:
+					_statistics.ect0 += packets;
+					break;
+				case ECN::CAPABLE_ECT_1:
+					_statistics.ect1 += packets;
+					break;
+				case ECN::CONGESTION_EXPERIENCED:
+					_statistics.ce += packets;
+					break;
+				default:
+					break;
+				}
+				
+				count += packets;
+			}
+			
+			batch._received = result;
+			batch._size = count;
+			
+			// The drop counter is cumulative, so only the most recent datagram needs to be checked:
+			if (result > 0) {
+				auto drops = get_drops(&messages[result - 1].msg_hdr);
+				
+				if (drops > static_cast<std::int64_t>(_statistics.drops)) {
+					_statistics.drops = drops;
+					
+					if (_receive_buffer_limit) grow_receive_buffer();
+				}
+			}
+			
+			if (DEBUG) std::cerr << *this << " receive_packets " << count << " packets in " << result << " datagrams" << std::endl;
+			
+			return count;
+		}
+		
+		bool Socket::set_receive_buffer_size(std::size_t size)
+		{
+			int value = size;
+			
+			return setsockopt(_descriptor, SOL_SOCKET, SO_RCVBUF, &value, static_cast<socklen_t>(sizeof(value))) == 0;
+		}
+		
+		std::size_t Socket::receive_buffer_size() const
+		{
+			int value = 0;
+			socklen_t size = sizeof(value);
+			
+			if (getsockopt(_descriptor, SOL_SOCKET, SO_RCVBUF, &value, &size) == -1) {
+				throw std::system_error(errno, std::generic_category(), "getsockopt");
+			}
+			
+			return value;
+		}
+		
+		bool Socket::set_send_buffer_size(std::size_t size)
+		{
+			int value = size;
+			
+			return setsockopt(_descriptor, SOL_SOCKET, SO_SNDBUF, &value, static_cast<socklen_t>(sizeof(value))) == 0;
+		}
+		
+		std::size_t Socket::send_buffer_size() const
+		{
+			int value = 0;
+			socklen_t size = sizeof(value);
+			
+			if (getsockopt(_descriptor, SOL_SOCKET, SO_SNDBUF, &value, &size) == -1) {
+				throw std::system_error(errno, std::generic_category(), "getsockopt");
+			}
+			
+			return value;
+		}
+		
+		void Socket::grow_receive_buffer()
+		{
+			auto size = receive_buffer_size();
+			
+			if (size >= _receive_buffer_limit) return;
+			
+			if (DEBUG) std::cerr << *this << " grow_receive_buffer " << size << " -> " << std::min(size * 2, _receive_buffer_limit) << std::endl;
+			
+			set_receive_buffer_size(std::min(size * 2, _receive_buffer_limit));
+		}
+		
+		bool Socket::set_busy_poll(std::uint64_t budget)
+		{
+			_busy_poll_budget = budget * 1000;
+			_busy = false;
+
+#if defined(SO_BUSY_POLL)
+			int value = budget;
+			
+			return setsockopt(_descriptor, SOL_SOCKET, SO_BUSY_POLL, &value, static_cast<socklen_t>(sizeof(value))) == 0 && budget > 0;
+#endif
+			
+			return false;
+		}
+		
+		std::size_t Socket::queue_depth() const
+		{
+#if defined(SO_MEMINFO)
+			// For UDP sockets, `SIOCINQ` only reports the size of the first datagram, while the memory information includes every queued datagram:
+			std::uint32_t information[SK_MEMINFO_VARS] = {};
+			socklen_t size = sizeof(information);
+			
+			if (getsockopt(_descriptor, SOL_SOCKET, SO_MEMINFO, information, &size) == 0) {
+				return information[SK_MEMINFO_RMEM_ALLOC];
+			}
+#endif
+			
+			int value = 0;
+			
+			if (ioctl(_descriptor, FIONREAD, &value) == -1) {
+				throw std::system_error(errno, std::generic_category(), "ioctl");
+			}
+			
+			return value;
 		}
 		
 		std::ostream & operator<<(std::ostream & output, const Socket & socket)
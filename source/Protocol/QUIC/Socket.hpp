@@ -9,11 +9,14 @@
 #pragma once
 
 #include "Address.hpp"
+#include "BufferPool.hpp"
 
 #include <Time/Interval.hpp>
 #include <Scheduler/Monitor.hpp>
 
 #include <algorithm>
+#include <deque>
+#include <memory>
 #include <cstdint>
 #include <string>
 #include <vector>
@@ -40,6 +43,20 @@ namespace Protocol
 			CONGESTION_EXPERIENCED = 0x03,
 		};
 		
+#if defined(__linux__)
+		using Message = mmsghdr;
+#else
+		// Mirrors the layout of `mmsghdr` on platforms that don't provide `recvmmsg` and `sendmmsg`.
+		struct Message {
+			msghdr msg_hdr;
+			unsigned int msg_len;
+		};
+#endif
+		
+		class ReceiveBatch;
+		class TransmitBatch;
+		class Ring;
+		
 		// The Socket class represents a UDP socket, which is used for sending and receiving QUIC packets. This class is used by the QUIC implementation to bind or connect a network socket and send and receive packets over that socket.
 		class Socket
 		{
@@ -61,24 +78,155 @@ namespace Protocol
 			int descriptor() const {return _descriptor;}
 			Scheduler::Monitor & monitor();
 			
+			enum class Backend {
+				// Non-blocking system calls, waiting for readiness using the scheduler.
+				READINESS,
+				
+				// io_uring, using a multishot receive into provided buffers and batched submission of sends.
+				RING,
+			};
+			
+			// Select the backend used for sending and receiving packets. If the backend is not available, the socket falls back to readiness.
+			// @returns the backend which is in use.
+			Backend set_backend(Backend backend);
+			Backend backend() const noexcept {return _ring ? Backend::RING : Backend::READINESS;}
+			
 			const Address & local_address() const;
 			const Address & remote_address() const;
 			
+			// Accept IPv4 packets (as IPv4-mapped IPv6 addresses) on an IPv6 socket, so that a single socket bound to `::` can serve both families. ECN codepoints are received and sent using `IP_TOS` for these packets. Must be called before binding.
+			// @returns whether the socket is dual-stack.
+			bool set_dual_stack(bool enabled);
+			
+			// Allow several sockets to bind to the same address and port (`SO_REUSEPORT`). Must be called before binding.
+			// @returns whether address reuse is enabled.
+			bool set_reuse_port(bool enabled);
+			
+			// Steer packets between the sockets bound to the same address with `set_reuse_port`, so that each socket can be driven by its own `Dispatcher` on its own core. A classic BPF program is attached to the group (`SO_ATTACH_REUSEPORT_CBPF`, which needs no privileges). Short header packets are delivered to the socket whose index in the group (the order in which the sockets were bound) is the byte at `worker_offset` in the destination connection ID, modulo the number of sockets: the worker index encoded by `ConnectionIDGenerator::generate`, see `Dispatcher::set_worker`. Long header packets, which start new connections, are distributed by the kernel's hash of the addresses, so the rest of the handshake reaches the same socket. May be called on any socket in the group, after binding.
+			// @returns whether the program was attached.
+			bool set_reuse_port_steering(std::size_t sockets, std::size_t worker_offset = 0);
+			
+			// Whether `set_reuse_port_steering` attached a program to the group using this socket. The kernel doesn't run the program while any socket in the group is connected, so `Configuration::connected_sockets` can't be used with steering.
+			bool reuse_port_steering() const noexcept {return _reuse_port_steering;}
+			
 			bool bind(const Address & address);
 			bool connect(const Address & address);
 			
+			// Create another socket object which shares this socket's kernel socket (using `dup`), but has its own transmit state. A socket object may only be used by one thread, so this allows other threads to send packets from the same address, e.g. the workers of a `Distributor`. Packets should only be received by one of the sockets, and zero-copy transmission is not inherited, since its completions are reported to the shared error queue.
+			Socket duplicate() const;
+			
 			void close();
 			
 			operator bool() const {return _descriptor >= 0;}
 			
+			// If transmissions are being held, the packet is added to the transmit batch instead of being sent immediately.
+			// @parameter segment_size if non-zero, the data is a train of packets of this size (the last one may be shorter), which are sent using segmentation offload where possible.
+			// @parameter departure_time if non-zero and transmit times are enabled, the time (in nanoseconds, on the monotonic clock) at which the kernel should send the packet.
+			// @parameter source if given and the socket is bound to a wildcard address, the local address to send the packet from, usually the address the peer's packets were received on.
+			// @returns the number of bytes sent, or 0 if a timeout occurred.
+			size_t send_packet(const void * data, std::size_t size, const Destination & destination, ECN ecn = ECN::UNSPECIFIED, const Timestamp * timeout = nullptr, std::size_t segment_size = 0, std::uint64_t departure_time = 0, const Destination * source = nullptr);
+			
+			// The default size above which packets sent with `send_buffer` are transmitted without copying.
+			static constexpr std::size_t ZERO_COPY_THRESHOLD = 1024*10;
+			
+			// Enable zero-copy transmission (`MSG_ZEROCOPY`) of packets sent with `send_buffer`. Packets smaller than the threshold are copied as usual, as tracking their completion costs more than the copy. Zero-copy is disabled automatically if the kernel reports that it had to copy the data anyway.
+			// @returns whether zero-copy transmission is enabled.
+			bool set_zero_copy(bool enabled, std::size_t threshold = ZERO_COPY_THRESHOLD);
+			bool zero_copy() const noexcept {return _zero_copy;}
+			
+			// Buffers for use with `send_buffer`.
+			BufferPool & buffer_pool() noexcept {return _buffer_pool;}
+			
+			// Send a packet (or packet train) from a buffer acquired from `buffer_pool()`. The socket takes ownership of the buffer, and returns it to the pool once the kernel has finished with it.
 			// @returns the number of bytes sent, or 0 if a timeout occurred.
-			size_t send_packet(const void * data, std::size_t size, const Destination & destination, ECN ecn = ECN::UNSPECIFIED, const Timestamp * timeout = nullptr);
+			size_t send_buffer(BufferPool::Buffer buffer, std::size_t size, const Destination & destination, ECN ecn = ECN::UNSPECIFIED, const Timestamp * timeout = nullptr, std::size_t segment_size = 0, std::uint64_t departure_time = 0, const Destination * source = nullptr);
+			
+			// Enable per-packet departure times (`SO_TXTIME`), so that the kernel's fq qdisc can pace transmissions. If the socket doesn't support them, the failure is remembered and later calls return false immediately.
+			// @returns whether transmit times are enabled.
+			bool set_transmit_time(bool enabled);
+			bool transmit_time() const noexcept {return _transmit_time;}
+			
+			// Set the differentiated services codepoint (the upper six bits of the traffic class) which is sent with every packet, alongside the packet's ECN codepoint.
+			void set_dscp(std::uint8_t dscp) noexcept {_dscp = dscp & 0x3F;}
+			std::uint8_t dscp() const noexcept {return _dscp;}
+			
+			struct Statistics {
+				// The number of packets received with each ECN codepoint, which shows whether ECN marks survive the network path:
+				std::size_t ect0 = 0;
+				std::size_t ect1 = 0;
+				std::size_t ce = 0;
+				
+				// The number of packets the kernel dropped because the receive buffer was full, as reported with the most recently received packet:
+				std::size_t drops = 0;
+			};
+			
+			const Statistics & statistics() const noexcept {return _statistics;}
+			
+			// Set the size of the kernel's receive buffer (`SO_RCVBUF`), which absorbs bursts of packets while they wait to be processed. The kernel may limit the size (e.g. `net.core.rmem_max`).
+			// @returns whether the size was set.
+			bool set_receive_buffer_size(std::size_t size);
+			
+			// @returns the size of the kernel's receive buffer, including the kernel's bookkeeping overhead.
+			std::size_t receive_buffer_size() const;
+			
+			// Set the size of the kernel's send buffer (`SO_SNDBUF`).
+			// @returns whether the size was set.
+			bool set_send_buffer_size(std::size_t size);
+			std::size_t send_buffer_size() const;
+			
+			// Grow the receive buffer (doubling it, up to the given size) whenever the kernel reports that it dropped packets. Zero disables growth.
+			void set_receive_buffer_limit(std::size_t limit) noexcept {_receive_buffer_limit = limit;}
+			
+			// The number of bytes waiting in the kernel's receive queue.
+			std::size_t queue_depth() const;
+			
+			// Enable low-latency receiving: while packets are arriving continuously, `receive_packets` spins on non-blocking receives for up to the given budget before waiting for readiness, avoiding the latency of a wakeup. The socket stops spinning as soon as a budget expires without any packets, and starts again once packets are found already waiting. The kernel is also asked to busy poll the device (`SO_BUSY_POLL`), which may require elevated privileges. Spinning blocks other fibers on the same thread, so the budget should be small. Zero disables busy polling.
+			// @parameter budget the maximum time to spin, in microseconds.
+			// @returns whether the kernel will busy poll the device.
+			bool set_busy_poll(std::uint64_t budget);
+			std::uint64_t busy_poll() const noexcept {return _busy_poll_budget / 1000;}
+			
+			// The default number of packets which can be queued when the socket is not writable.
+			static constexpr std::size_t TRANSMIT_QUEUE_CAPACITY = 64;
+			
+			// Set the number of packets which can be queued when the kernel's send buffer is full. Rather than waiting for the socket to become writable, sends are queued and return immediately, and queued packets are sent (in order) ahead of any later packets. Only if the queue is full does sending wait. Zero disables queueing.
+			void set_transmit_queue(std::size_t capacity);
+			
+			// Try to send any queued packets without waiting. Connections should stop writing packets while the socket is backlogged, so that the queue doesn't overflow.
+			// @returns whether packets are still queued.
+			bool backlogged();
 			
+			// Wait until all queued packets have been sent.
+			// @returns whether the queue is empty, which is false if a timeout occurred.
+			bool flush_transmit_queue(const Timestamp * timeout = nullptr);
+			
+			// Whether packet trains are segmented by the kernel (UDP generic segmentation offload). This is disabled automatically if the kernel reports that it's not supported.
+			bool segmentation_offload() const noexcept {return _segmentation_offload;}
+			
+			// Send all the packets in the batch, using a single system call where possible. The batch is cleared afterwards.
+			// @returns the number of packets sent, which is less than the size of the batch if a timeout occurred.
+			std::size_t send_packets(TransmitBatch & batch, const Timestamp * timeout = nullptr);
+			
+			// Hold packets passed to `send_packet` in a transmit batch, rather than sending them immediately. Calls may be nested, and each must be balanced by a call to `flush`.
+			void hold();
+			
+			// Balance a call to `hold`. When the outermost hold is released, all held packets are sent together.
+			void flush(const Timestamp * timeout = nullptr);
+			
+			// Receive a single packet. Datagrams coalesced by the kernel are split, and their packets returned one at a time.
 			// @parameter address is set to the address of the sender (remote peer).
 			// @returns the number of bytes received, or 0 if a timeout occurred.
 			size_t receive_packet(void * data, std::size_t size, Address & address, ECN & ecn, const Timestamp * timeout = nullptr);
 			
+			// Receive as many datagrams as are available, up to the capacity of the batch, using a single system call where possible. Datagrams coalesced by the kernel are split into their individual packets. Any packets in the batch which were not consumed are discarded.
+			// @returns the number of packets received, or 0 if a timeout occurred.
+			std::size_t receive_packets(ReceiveBatch & batch, const Timestamp * timeout = nullptr);
+			
 		private:
+			// Take ownership of an existing descriptor:
+			struct Descriptor {int value;};
+			explicit Socket(Descriptor descriptor);
+			
 			int _descriptor = -1;
 			Scheduler::Monitor _monitor;
 			
@@ -86,7 +234,75 @@ namespace Protocol
 			// May be set by bind/connect.
 			mutable Address _local_address, _remote_address;
 			
-			ECN _ecn = ECN::UNSPECIFIED;
+			std::uint8_t _dscp = 0;
+			Statistics _statistics;
+			std::size_t _receive_buffer_limit = 0;
+			
+			// The busy poll budget in nanoseconds, and whether packets are arriving quickly enough that it's worth spinning:
+			std::uint64_t _busy_poll_budget = 0;
+			bool _busy = false;
+			
+			// Double the size of the receive buffer, up to the limit.
+			void grow_receive_buffer();
+			
+			// Whether the socket is bound to a wildcard address, in which case the source address of each packet must be specified:
+			bool _wildcard = false;
+			
+			bool _reuse_port_steering = false;
+			
+			bool _segmentation_offload = false;
+			bool _transmit_time = false;
+			bool _transmit_time_unsupported = false;
+			
+			// Make a single attempt to send a packet.
+			// @returns the number of bytes sent, or -1 if an error occurred (errno is set).
+			ssize_t send_message(const void * data, std::size_t size, const Destination & destination, ECN ecn, std::size_t segment_size, std::uint64_t departure_time, const Destination * source, int flags = 0);
+			
+			// Send a packet immediately, ignoring any hold:
+			size_t transmit(const void * data, std::size_t size, const Destination & destination, ECN ecn, const Timestamp * timeout, std::size_t segment_size = 0, std::uint64_t departure_time = 0, const Destination * source = nullptr);
+			
+			// Send each segment of a packet train as an individual datagram:
+			size_t transmit_segments(const void * data, std::size_t size, const Destination & destination, ECN ecn, const Timestamp * timeout, std::size_t segment_size, std::uint64_t departure_time, const Destination * source);
+			
+			// Packets waiting for the socket to become writable, see `set_transmit_queue`:
+			std::unique_ptr<TransmitBatch> _transmit_queue;
+			std::size_t _transmit_queue_capacity = TRANSMIT_QUEUE_CAPACITY;
+			
+			// Add a packet to the transmit queue, splitting it into segments if it can't be segmented by the kernel.
+			// @returns false if queueing is disabled or the queue doesn't have enough space.
+			bool queue_packet(const void * data, std::size_t size, const Destination & destination, ECN ecn, std::size_t segment_size, std::uint64_t departure_time, const Destination * source);
+			
+			// Add the packets in the batch, starting at offset, to the transmit queue. Either all the packets are queued, or none.
+			bool queue_packets(TransmitBatch & batch, std::size_t offset);
+			
+			// Send as many queued packets as possible without waiting.
+			// @returns whether the queue is empty.
+			bool transmit_queue();
+			
+			// Add the control messages (traffic class, segmentation, departure time and source address) for each packet in the batch.
+			Message * prepare_messages(TransmitBatch & batch);
+			
+			// Packets held for transmission, see `hold` and `flush`:
+			std::unique_ptr<TransmitBatch> _transmit_batch;
+			std::size_t _hold_count = 0;
+			
+			// Used by `receive_packet`, allocated on first use:
+			std::unique_ptr<ReceiveBatch> _receive_batch;
+			
+			// The io_uring backend, if selected:
+			std::unique_ptr<Ring> _ring;
+			
+			BufferPool _buffer_pool;
+			
+			bool _zero_copy = false;
+			std::size_t _zero_copy_threshold = ZERO_COPY_THRESHOLD;
+			
+			// Buffers which the kernel is still using, identified by the sequence number of the send which used them:
+			std::uint32_t _zero_copy_sequence = 0;
+			std::deque<std::pair<std::uint32_t, BufferPool::Buffer>> _zero_copy_pending;
+			
+			// Read zero-copy completions from the error queue, and return the released buffers to the pool.
+			void release_zero_copy_buffers();
 		};
 		
 		std::ostream & operator<<(std::ostream & output, const Socket & socket);
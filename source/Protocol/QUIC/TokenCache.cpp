@@ -0,0 +1,35 @@
+//
+//  TokenCache.cpp
+//  This file is part of the "Protocol::QUIC" project and released under the MIT License.
+//
+//  Created by Samuel Williams on 16/10/2026.
+//  Copyright, 2026, by Samuel Williams. All rights reserved.
+//
+
+#include "TokenCache.hpp"
+
+namespace Protocol
+{
+	namespace QUIC
+	{
+		TokenCache::TokenCache(std::size_t capacity, Clock::duration lifetime) : _cache(capacity, lifetime, true)
+		{
+		}
+		
+		TokenCache::~TokenCache()
+		{
+		}
+		
+		std::string TokenCache::take(const Address & address)
+		{
+			return _cache.take(address).value_or(std::string());
+		}
+		
+		void TokenCache::store(const Address & address, const std::uint8_t * token, std::size_t length)
+		{
+			if (length == 0) return;
+			
+			_cache.store(address, std::string(reinterpret_cast<const char *>(token), length));
+		}
+	}
+}
@@ -0,0 +1,52 @@
+//
+//  TokenCache.hpp
+//  This file is part of the "Protocol::QUIC" project and released under the MIT License.
+//
+//  Created by Samuel Williams on 16/10/2026.
+//  Copyright, 2026, by Samuel Williams. All rights reserved.
+//
+
+#pragma once
+
+#include "ExpiringCache.hpp"
+
+#include <cstdint>
+#include <string>
+
+namespace Protocol
+{
+	namespace QUIC
+	{
+		// The TokenCache class remembers the most recent address validation token (NEW_TOKEN frame) issued by each server, keyed by the server's address and port. A client reconnecting to the server presents the token in its Initial packet, so that the server can treat its address as validated from the first flight. Tokens are removed when they are used, as reusing a token would allow the connections to be linked (RFC 9000 §8.1.3).
+		class TokenCache
+		{
+		public:
+			using Clock = ExpiringCache<std::string>::Clock;
+			
+			static constexpr std::size_t DEFAULT_CAPACITY = 1024;
+			static constexpr Clock::duration DEFAULT_LIFETIME = std::chrono::hours(1);
+			
+			TokenCache(std::size_t capacity = DEFAULT_CAPACITY, Clock::duration lifetime = DEFAULT_LIFETIME);
+			~TokenCache();
+			
+			TokenCache(const TokenCache &) = delete;
+			TokenCache & operator=(const TokenCache &) = delete;
+			
+			// The number of cached tokens, including any which have expired but not yet been evicted.
+			std::size_t size() const {return _cache.size();}
+			
+			// Remove and return the token for the given server.
+			// @returns the token, or an empty string if there is none or it has expired.
+			std::string take(const Address & address);
+			
+			// Remember a token issued by the given server, replacing any previous token.
+			void store(const Address & address, const std::uint8_t * token, std::size_t length);
+			
+			void clear() {_cache.clear();}
+			
+		private:
+			// Keyed by address and port, as several servers may share a host:
+			ExpiringCache<std::string> _cache;
+		};
+	}
+}
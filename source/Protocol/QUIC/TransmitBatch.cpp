@@ -0,0 +1,114 @@
+//
+//  TransmitBatch.cpp
+//  This file is part of the "Protocol::QUIC" project and released under the MIT License.
+//
+//  Created by Samuel Williams on 16/10/2026.
+//  Copyright, 2026, by Samuel Williams. All rights reserved.
+//
+
+#include "TransmitBatch.hpp"
+
+#include <algorithm>
+#include <cassert>
+
+namespace Protocol
+{
+	namespace QUIC
+	{
+		TransmitBatch::TransmitBatch(std::size_t capacity, std::size_t buffer_size) :
+			_capacity(capacity),
+			_buffer(buffer_size),
+			_packets(capacity),
+			_messages(capacity),
+			_iovecs(capacity),
+			_control(capacity * CONTROL_SIZE)
+		{
+			assert(capacity > 0);
+		}
+		
+		TransmitBatch::~TransmitBatch()
+		{
+		}
+		
+		bool TransmitBatch::append(const void * data, std::size_t size, const Destination & destination, ECN ecn, std::size_t segment_size, std::uint64_t departure_time, const Destination * source)
+		{
+			if (_size == _capacity || _used + size > _buffer.size()) {
+				return false;
+			}
+			
+			auto & packet = _packets[_size++];
+			
+			packet.offset = _used;
+			packet.size = size;
+			packet.destination.set(destination.addr, destination.addrlen);
+			packet.ecn = ecn;
+			packet.segment_size = segment_size;
+			packet.departure_time = departure_time;
+			
+			if (source) {
+				packet.source.set(source->addr, source->addrlen);
+			} else {
+				packet.source.length = 0;
+			}
+			
+			std::copy_n(static_cast<const Byte *>(data), size, _buffer.data() + _used);
+			_used += size;
+			
+			return true;
+		}
+		
+		void TransmitBatch::clear()
+		{
+			_size = 0;
+			_used = 0;
+		}
+		
+		void TransmitBatch::consume(std::size_t count)
+		{
+			if (count >= _size) {
+				clear();
+				return;
+			}
+			
+			// Move the remaining packets to the front of the buffer:
+			auto start = _packets[count].offset;
+			std::copy(_buffer.begin() + start, _buffer.begin() + _used, _buffer.begin());
+			_used -= start;
+			
+			for (std::size_t index = count; index < _size; index += 1) {
+				auto & packet = _packets[index - count];
+				packet = _packets[index];
+				packet.offset -= start;
+			}
+			
+			_size -= count;
+		}
+		
+		Message * TransmitBatch::prepare(bool connected)
+		{
+			for (std::size_t index = 0; index < _size; index += 1) {
+				auto & packet = _packets[index];
+				auto & iov = _iovecs[index];
+				auto & message = _messages[index];
+				
+				iov.iov_base = _buffer.data() + packet.offset;
+				iov.iov_len = packet.size;
+				
+				message.msg_hdr = msghdr{};
+				message.msg_hdr.msg_iov = &iov;
+				message.msg_hdr.msg_iovlen = 1;
+				message.msg_hdr.msg_control = _control.data() + (index * CONTROL_SIZE);
+				
+				if (!connected) {
+					// Not connected, so we need to set the destination address:
+					message.msg_hdr.msg_name = &packet.destination.data;
+					message.msg_hdr.msg_namelen = packet.destination.length;
+				}
+				
+				message.msg_len = 0;
+			}
+			
+			return _messages.data();
+		}
+	}
+}
@@ -0,0 +1,99 @@
+//
+//  TransmitBatch.hpp
+//  This file is part of the "Protocol::QUIC" project and released under the MIT License.
+//
+//  Created by Samuel Williams on 16/10/2026.
+//  Copyright, 2026, by Samuel Williams. All rights reserved.
+//
+
+#pragma once
+
+#include "Socket.hpp"
+
+#include <cstdint>
+#include <vector>
+
+namespace Protocol
+{
+	namespace QUIC
+	{
+		// The TransmitBatch class gathers outgoing packets so that they can be sent with a single system call. Each packet is copied into the batch and keeps its own destination and ECN codepoint, so packets from many different connections can share one batch.
+		class TransmitBatch
+		{
+		public:
+			static constexpr std::size_t DEFAULT_CAPACITY = 64;
+			static constexpr std::size_t DEFAULT_BUFFER_SIZE = 1024*256;
+			
+			// The size of the ancillary data buffer reserved for each message.
+			static constexpr std::size_t CONTROL_SIZE = 128;
+			
+			struct Packet {
+				std::size_t offset = 0;
+				std::size_t size = 0;
+				
+				Address destination;
+				ECN ecn = ECN::UNSPECIFIED;
+				
+				// If non-zero, the packet is a train of segments of this size.
+				std::size_t segment_size = 0;
+				
+				// If non-zero, the time at which the kernel should send the packet.
+				std::uint64_t departure_time = 0;
+				
+				// If set, the local address the packet is sent from.
+				Address source;
+			};
+			
+			// @parameter buffer_size must be large enough to hold the largest packet.
+			TransmitBatch(std::size_t capacity = DEFAULT_CAPACITY, std::size_t buffer_size = DEFAULT_BUFFER_SIZE);
+			~TransmitBatch();
+			
+			TransmitBatch(const TransmitBatch &) = delete;
+			TransmitBatch & operator=(const TransmitBatch &) = delete;
+			
+			// The maximum number of packets the batch can hold.
+			std::size_t capacity() const noexcept {return _capacity;}
+			
+			// The number of packets in the batch.
+			std::size_t size() const noexcept {return _size;}
+			
+			bool empty() const noexcept {return _size == 0;}
+			
+			// Whether the batch has enough space for the given number of packets, totalling the given number of bytes.
+			bool fits(std::size_t count, std::size_t size) const noexcept {return _size + count <= _capacity && _used + size <= _buffer.size();}
+			
+			// Copy a packet (or packet train) into the batch.
+			// @parameter source if given, the local address the packet is sent from.
+			// @returns false if the batch does not have enough space for the packet.
+			bool append(const void * data, std::size_t size, const Destination & destination, ECN ecn = ECN::UNSPECIFIED, std::size_t segment_size = 0, std::uint64_t departure_time = 0, const Destination * source = nullptr);
+			
+			// Discard all the packets in the batch.
+			void clear();
+			
+			// Discard the given number of packets from the front of the batch, e.g. once they have been sent.
+			void consume(std::size_t count);
+			
+		private:
+			friend class Socket;
+			
+			std::size_t _capacity;
+			
+			std::size_t _size = 0;
+			
+			// The number of bytes of the buffer in use:
+			std::size_t _used = 0;
+			
+			std::vector<Byte> _buffer;
+			std::vector<Packet> _packets;
+			
+			// Message headers, io vectors and control buffers, reused by every send:
+			std::vector<Message> _messages;
+			std::vector<iovec> _iovecs;
+			std::vector<Byte> _control;
+			
+			// Prepare the message headers for sending the batch. Each message has an empty control buffer of `CONTROL_SIZE` bytes which the socket can append to.
+			// @parameter connected if true, the destination address is omitted.
+			Message * prepare(bool connected);
+		};
+	}
+}
@@ -85,6 +85,16 @@ namespace Protocol
 			
 			std::vector<std::unique_ptr<EchoStream>> streams;
 			
+			// The number of servers which moved to a connected socket after the handshake:
+			static inline std::size_t connected_sockets = 0;
+			
+			void handshake_completed() override
+			{
+				Server::handshake_completed();
+				
+				if (_socket) connected_sockets += 1;
+			}
+			
 			Stream * create_stream(StreamID stream_id) override
 			{
 				auto &stream = streams.emplace_back(std::make_unique<EchoStream>(*this, stream_id));
@@ -98,9 +108,15 @@ namespace Protocol
 		public:
 			using Dispatcher::Dispatcher;
 			
-			Server * create_server(Socket &socket, const Address &address, const ngtcp2_pkt_hd &packet_header) override
+			// The number of servers created for clients which presented a valid address validation token:
+			static inline std::size_t validated_tokens = 0;
+			
+			Server * create_server(Socket &socket, const Address &local_address, const Address &remote_address, const ngtcp2_pkt_hd &packet_header, ngtcp2_cid *ocid) override
 			{
-				auto server = new EchoServer(*this, _configuration, _tls_context, socket, address, packet_header);
+				// The dispatcher removes tokens it couldn't validate:
+				if (packet_header.tokenlen > 0 && !ocid) validated_tokens += 1;
+				
+				auto server = new EchoServer(*this, _configuration, _tls_context, socket, local_address, remote_address, packet_header, ocid);
 				
 				return server;
 			}
@@ -136,8 +152,10 @@ namespace Protocol
 							Socket socket(address.family());
 							socket.bind(address);
 							
+							ReceiveBatch batch;
+							
 							while (true) {
-								auto server = dispatcher.listen(socket);
+								auto server = dispatcher.listen(socket, batch);
 								
 								if (server) {
 									auto server_fiber = std::make_unique<Scheduler::Fiber>("server", [&] {
@@ -204,6 +222,319 @@ namespace Protocol
 					}
 				}
 			},
+			
+			{"it serves IPv4 and IPv6 clients from one dual-stack socket",
+				[](UnitTest::Examiner & examiner) {
+					Scheduler::Reactor::Bound bound;
+					Configuration configuration;
+					
+					auto addresses = Protocol::QUIC::Address::resolve("localhost", "4435");
+					
+					Protocol::QUIC::TLS::ServerContext tls_server_context;
+					tls_server_context.load_certificate_file("Protocol/QUIC/server.pem");
+					tls_server_context.load_private_key_file("Protocol/QUIC/server.key");
+					tls_server_context.protocols().push_back("txt");
+					
+					EchoDispatcher dispatcher(configuration, tls_server_context);
+					
+					std::vector<std::unique_ptr<Scheduler::Fiber>> fibers;
+					
+					// A single dual-stack socket bound to the wildcard address serves clients connecting over both IPv4 and IPv6:
+					auto wildcard_addresses = Protocol::QUIC::Address::resolve("::", "4435", AF_INET6, SOCK_DGRAM, AI_PASSIVE|AI_NUMERICHOST);
+					auto & wildcard = wildcard_addresses.front();
+					
+					auto listening_fiber = std::make_unique<Scheduler::Fiber>("listening on " + wildcard.to_string(), [&] {
+						// This fiber won't prevent the event loop from exiting.
+						Scheduler::Fiber::current->transient = true;
+						
+						Socket socket(AF_INET6);
+						socket.set_dual_stack(true);
+						socket.bind(wildcard);
+						
+						ReceiveBatch batch;
+						
+						while (true) {
+							auto server = dispatcher.listen(socket, batch);
+							
+							if (server) {
+								auto server_fiber = std::make_unique<Scheduler::Fiber>("server", [&] {
+									server->accept();
+								});
+								
+								Scheduler::Reactor::current->transfer(server_fiber.get());
+								
+								fibers.push_back(std::move(server_fiber));
+							}
+						}
+					});
+					
+					listening_fiber->transfer();
+					
+					fibers.push_back(std::move(listening_fiber));
+					
+					Protocol::QUIC::TLS::ClientContext tls_client_context;
+					tls_client_context.protocols().push_back("txt");
+					
+					std::vector<std::string> received_data;
+					
+					auto client_fiber = std::make_unique<Scheduler::Fiber>([&] {
+						for (auto & address : addresses) {
+							Scheduler::Fiber::current->annotate(std::string("connecting to ") + address.to_string());
+							
+							Socket socket(address.family());
+							socket.connect(address);
+							
+							EchoClient client(configuration, tls_client_context, socket, address);
+							
+							auto stream_fiber = std::make_unique<Scheduler::Fiber>("stream", [&] {
+								client.handshake.acquire();
+								
+								EchoStream *stream = dynamic_cast<EchoStream*>(client.open_bidirectional_stream());
+								stream->output_buffer().append("Hello World");
+								stream->output_buffer().close();
+								stream->data_received.acquire();
+								
+								received_data.push_back(std::string(stream->input_buffer().data()));
+								
+								client.close();
+							});
+							
+							Scheduler::Reactor::current->transfer(stream_fiber.get());
+							
+							client.connect();
+						}
+						
+						dispatcher.close();
+					});
+					
+					client_fiber->transfer();
+					
+					fibers.push_back(std::move(client_fiber));
+					
+					bound.reactor.run();
+					
+					// Assert after the reactor finishes so assertions are attributed to this test case:
+					examiner.expect(received_data.size()).to(be == addresses.size());
+					for (auto & data : received_data) {
+						examiner.expect(data).to(be == "Hello World");
+					}
+				}
+			},
+			
+			{"it hands established connections over to connected sockets",
+				[](UnitTest::Examiner & examiner) {
+					Scheduler::Reactor::Bound bound;
+					Configuration configuration;
+					configuration.connected_sockets = true;
+					
+					auto address = Protocol::QUIC::Address::resolve("127.0.0.1", "4434", AF_INET, SOCK_DGRAM, AI_NUMERICHOST).front();
+					
+					Protocol::QUIC::TLS::ServerContext tls_server_context;
+					tls_server_context.load_certificate_file("Protocol/QUIC/server.pem");
+					tls_server_context.load_private_key_file("Protocol/QUIC/server.key");
+					tls_server_context.protocols().push_back("txt");
+					
+					EchoDispatcher dispatcher(configuration, tls_server_context);
+					EchoServer::connected_sockets = 0;
+					
+					std::vector<std::unique_ptr<Scheduler::Fiber>> fibers;
+					
+					auto listening_fiber = std::make_unique<Scheduler::Fiber>("listening on " + address.to_string(), [&] {
+						Scheduler::Fiber::current->transient = true;
+						
+						// Connected sockets join the listening socket's group:
+						Socket socket(AF_INET);
+						socket.set_reuse_port(true);
+						socket.bind(address);
+						
+						while (true) {
+							auto server = dispatcher.listen(socket);
+							
+							if (server) {
+								auto server_fiber = std::make_unique<Scheduler::Fiber>("server", [&] {
+									server->accept();
+								});
+								
+								Scheduler::Reactor::current->transfer(server_fiber.get());
+								
+								fibers.push_back(std::move(server_fiber));
+							}
+						}
+					});
+					
+					listening_fiber->transfer();
+					
+					fibers.push_back(std::move(listening_fiber));
+					
+					Protocol::QUIC::TLS::ClientContext tls_client_context;
+					tls_client_context.protocols().push_back("txt");
+					
+					std::vector<std::string> received_data;
+					
+					auto client_fiber = std::make_unique<Scheduler::Fiber>([&] {
+						// Several connections in turn, so that later handshakes arrive while earlier connections own connected sockets in the group:
+						for (std::size_t index = 0; index < 3; index += 1) {
+							Socket socket(AF_INET);
+							socket.connect(address);
+							
+							EchoClient client(configuration, tls_client_context, socket, address);
+							
+							auto stream_fiber = std::make_unique<Scheduler::Fiber>("stream", [&] {
+								client.handshake.acquire();
+								
+								EchoStream *stream = dynamic_cast<EchoStream*>(client.open_bidirectional_stream());
+								stream->output_buffer().append("Hello World");
+								stream->output_buffer().close();
+								stream->data_received.acquire();
+								
+								received_data.push_back(std::string(stream->input_buffer().data()));
+								
+								client.close();
+							});
+							
+							Scheduler::Reactor::current->transfer(stream_fiber.get());
+							
+							client.connect();
+						}
+						
+						dispatcher.close();
+					});
+					
+					client_fiber->transfer();
+					
+					fibers.push_back(std::move(client_fiber));
+					
+					bound.reactor.run();
+					
+					examiner.expect(EchoServer::connected_sockets).to(be == 3);
+					examiner.expect(received_data.size()).to(be == 3);
+					for (auto & data : received_data) {
+						examiner.expect(data).to(be == "Hello World");
+					}
+				}
+			},
+			
+			{"it validates reconnecting clients using tokens from a previous connection",
+				[](UnitTest::Examiner & examiner) {
+					Scheduler::Reactor::Bound bound;
+					Configuration configuration;
+					configuration.new_tokens = true;
+					configuration.token_cache = std::make_shared<TokenCache>();
+					
+					auto address = Protocol::QUIC::Address::resolve("127.0.0.1", "4436", AF_INET, SOCK_DGRAM, AI_NUMERICHOST).front();
+					
+					Protocol::QUIC::TLS::ServerContext tls_server_context;
+					tls_server_context.load_certificate_file("Protocol/QUIC/server.pem");
+					tls_server_context.load_private_key_file("Protocol/QUIC/server.key");
+					tls_server_context.protocols().push_back("txt");
+					
+					EchoDispatcher dispatcher(configuration, tls_server_context);
+					EchoDispatcher::validated_tokens = 0;
+					
+					std::vector<std::unique_ptr<Scheduler::Fiber>> fibers;
+					
+					auto listening_fiber = std::make_unique<Scheduler::Fiber>("listening on " + address.to_string(), [&] {
+						Scheduler::Fiber::current->transient = true;
+						
+						Socket socket(AF_INET);
+						socket.bind(address);
+						
+						while (true) {
+							auto server = dispatcher.listen(socket);
+							
+							if (server) {
+								auto server_fiber = std::make_unique<Scheduler::Fiber>("server", [&] {
+									server->accept();
+								});
+								
+								Scheduler::Reactor::current->transfer(server_fiber.get());
+								
+								fibers.push_back(std::move(server_fiber));
+							}
+						}
+					});
+					
+					listening_fiber->transfer();
+					
+					fibers.push_back(std::move(listening_fiber));
+					
+					Protocol::QUIC::TLS::ClientContext tls_client_context;
+					tls_client_context.protocols().push_back("txt");
+					
+					std::vector<std::string> received_data;
+					
+					auto client_fiber = std::make_unique<Scheduler::Fiber>([&] {
+						// The first connection receives a token, which the second presents:
+						for (std::size_t index = 0; index < 2; index += 1) {
+							Socket socket(AF_INET);
+							socket.connect(address);
+							
+							EchoClient client(configuration, tls_client_context, socket, address);
+							
+							auto stream_fiber = std::make_unique<Scheduler::Fiber>("stream", [&] {
+								client.handshake.acquire();
+								
+								EchoStream *stream = dynamic_cast<EchoStream*>(client.open_bidirectional_stream());
+								stream->output_buffer().append("Hello World");
+								stream->output_buffer().close();
+								stream->data_received.acquire();
+								
+								received_data.push_back(std::string(stream->input_buffer().data()));
+								
+								client.close();
+							});
+							
+							Scheduler::Reactor::current->transfer(stream_fiber.get());
+							
+							client.connect();
+						}
+						
+						dispatcher.close();
+					});
+					
+					client_fiber->transfer();
+					
+					fibers.push_back(std::move(client_fiber));
+					
+					bound.reactor.run();
+					
+					examiner.expect(EchoDispatcher::validated_tokens).to(be == 1);
+					
+					// The second connection was also issued a token, for the next connection:
+					examiner.expect(configuration.token_cache->size()).to(be == 1);
+					
+					examiner.expect(received_data.size()).to(be == 2);
+					for (auto & data : received_data) {
+						examiner.expect(data).to(be == "Hello World");
+					}
+				}
+			},
+			
+			{"it rejects connected sockets with reuse port steering",
+				[](UnitTest::Examiner & examiner) {
+					Configuration configuration;
+					configuration.connected_sockets = true;
+					
+					Protocol::QUIC::TLS::ServerContext tls_server_context;
+					EchoDispatcher dispatcher(configuration, tls_server_context);
+					
+					Socket socket(AF_INET);
+					socket.set_reuse_port(true);
+					socket.bind(Protocol::QUIC::Address::resolve("127.0.0.1", "0", AF_INET, SOCK_DGRAM, AI_NUMERICHOST).front());
+					
+					if (!socket.set_reuse_port_steering(1)) return;
+					
+					bool failed = false;
+					
+					try {
+						dispatcher.listen(socket);
+					} catch (const std::invalid_argument &) {
+						failed = true;
+					}
+					
+					examiner.expect(failed).to(be == true);
+				}
+			},
 		};
 	}
 }
@@ -0,0 +1,111 @@
+//
+//  ConnectionIDGenerator.cpp
+//  This file is part of the "Protocol QUIC" project and released under the MIT License.
+//
+//  Created by Samuel Williams on 16/10/2026.
+//  Copyright, 2026, by Samuel Williams. All rights reserved.
+//
+
+#include <UnitTest/UnitTest.hpp>
+
+#include <Protocol/QUIC/ConnectionIDGenerator.hpp>
+
+#include <cstring>
+#include <stdexcept>
+
+namespace Protocol
+{
+	namespace QUIC
+	{
+		using namespace UnitTest::Expectations;
+		
+		UnitTest::Suite ConnectionIDGeneratorTestSuite {
+			"Protocol::QUIC::ConnectionIDGenerator",
+			
+			{"it generates random connection IDs which encode the worker",
+				[](UnitTest::Examiner & examiner) {
+					ConnectionIDGenerator generator(12);
+					ngtcp2_cid cid;
+					
+					generator.generate(&cid, 3, 4);
+					
+					examiner.expect(cid.datalen).to(be == 12);
+					examiner.expect(cid.data[generator.worker_offset()]).to(be == 3);
+				}
+			},
+			
+			{"it generates routable connection IDs",
+				[](UnitTest::Examiner & examiner) {
+					RoutableConnectionIDGenerator generator(2, {0x12, 0x34}, 10);
+					ngtcp2_cid cid;
+					
+					generator.generate(&cid, 5, 8);
+					
+					examiner.expect(cid.datalen).to(be == 10);
+					
+					// The config rotation codepoint and the length of the rest of the connection ID:
+					examiner.expect(cid.data[0]).to(be == ((2 << 5) | 9));
+					examiner.expect(cid.data[1]).to(be == 0x12);
+					examiner.expect(cid.data[2]).to(be == 0x34);
+					examiner.expect(cid.data[generator.worker_offset()]).to(be == 5);
+					
+					std::uint8_t server_id[2] = {};
+					examiner.expect(generator.decode(cid.data, cid.datalen, server_id)).to(be == true);
+					examiner.expect(server_id[0]).to(be == 0x12);
+					examiner.expect(server_id[1]).to(be == 0x34);
+					
+					// A different config rotation codepoint:
+					cid.data[0] = (3 << 5) | 9;
+					examiner.expect(generator.decode(cid.data, cid.datalen, server_id)).to(be == false);
+				}
+			},
+			
+			{"it encrypts routable connection IDs",
+				[](UnitTest::Examiner & examiner) {
+					RoutableConnectionIDGenerator::Key key = {0x4d, 0x5c, 0x3f, 0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07, 0x08, 0x09, 0x0a, 0x0b, 0x0c, 0x0d};
+					RoutableConnectionIDGenerator generator(0, {0xAB, 0xCD, 0xEF}, 17, key);
+					
+					ngtcp2_cid first, second;
+					generator.generate(&first);
+					generator.generate(&second);
+					
+					examiner.expect(first.datalen).to(be == 17);
+					
+					// The server ID is not visible:
+					examiner.expect(std::memcmp(first.data + 1, second.data + 1, 3) != 0).to(be == true);
+					
+					std::uint8_t server_id[3] = {};
+					examiner.expect(generator.decode(first.data, first.datalen, server_id)).to(be == true);
+					examiner.expect(server_id[0]).to(be == 0xAB);
+					examiner.expect(server_id[2]).to(be == 0xEF);
+					
+					// Encrypted connection IDs can't be steered to a worker:
+					examiner.expect(generator.maximum_workers()).to(be == 1);
+					
+					bool failed = false;
+					try {
+						generator.generate(&first, 1, 2);
+					} catch (const std::logic_error &) {
+						failed = true;
+					}
+					
+					examiner.expect(failed).to(be == true);
+				}
+			},
+			
+			{"it rejects connection IDs too short for the nonce",
+				[](UnitTest::Examiner & examiner) {
+					bool failed = false;
+					
+					try {
+						RoutableConnectionIDGenerator generator(0, {0x01, 0x02, 0x03, 0x04}, 8);
+					} catch (const std::invalid_argument &) {
+						failed = true;
+					}
+					
+					examiner.expect(failed).to(be == true);
+				}
+			},
+		};
+	}
+}
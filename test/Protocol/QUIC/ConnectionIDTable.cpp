@@ -0,0 +1,164 @@
+//
+//  ConnectionIDTable.cpp
+//  This file is part of the "Protocol QUIC" project and released under the MIT License.
+//
+//  Created by Samuel Williams on 16/10/2026.
+//  Copyright, 2026, by Samuel Williams. All rights reserved.
+//
+
+#include <UnitTest/UnitTest.hpp>
+
+#include <Protocol/QUIC/ConnectionIDTable.hpp>
+
+#include <chrono>
+#include <iostream>
+#include <string>
+#include <unordered_map>
+
+namespace Protocol
+{
+	namespace QUIC
+	{
+		using namespace UnitTest::Expectations;
+		
+		static std::vector<ConnectionID> generate_connection_ids(std::size_t count, std::size_t length)
+		{
+			Random random;
+			std::vector<ConnectionID> connection_ids(count);
+			
+			for (auto & connection_id : connection_ids) {
+				connection_id.length = length;
+				random.generate(connection_id.data.data(), length);
+			}
+			
+			return connection_ids;
+		}
+		
+		template <typename Function>
+		static double measure_nanoseconds_per_lookup(std::size_t count, Function function)
+		{
+			auto start = std::chrono::steady_clock::now();
+			function();
+			auto duration = std::chrono::steady_clock::now() - start;
+			
+			return std::chrono::duration<double, std::nano>(duration).count() / count;
+		}
+		
+		UnitTest::Suite ConnectionIDTableTestSuite {
+			"Protocol::QUIC::ConnectionIDTable",
+			
+			{"it computes the SipHash-2-4 reference values",
+				[](UnitTest::Examiner & examiner) {
+					SipHash hash{0x0706050403020100ULL, 0x0f0e0d0c0b0a0908ULL};
+					std::uint8_t message[15];
+					
+					for (std::size_t index = 0; index < sizeof(message); index += 1) {
+						message[index] = index;
+					}
+					
+					examiner.expect(hash(message, 0)).to(be == 0x726fdb47dd0e0e31ULL);
+					examiner.expect(hash.hash<8>(message)).to(be == 0x93f5f5799a932462ULL);
+					examiner.expect(hash(message, 8)).to(be == 0x93f5f5799a932462ULL);
+					examiner.expect(hash(message, 15)).to(be == 0xa129ca6149be45e5ULL);
+				}
+			},
+			
+			{"it can insert, find and erase connection IDs",
+				[](UnitTest::Examiner & examiner) {
+					ConnectionIDTable<int> table(4);
+					
+					auto connection_ids = generate_connection_ids(100, DEFAULT_SCID_LENGTH);
+					
+					// Connection IDs of other lengths, including zero length, are also supported:
+					connection_ids.push_back(ConnectionID());
+					connection_ids.push_back(generate_connection_ids(1, NGTCP2_MAX_CIDLEN).front());
+					
+					for (std::size_t index = 0; index < connection_ids.size(); index += 1) {
+						examiner.expect(table.insert(connection_ids[index], index)).to(be == true);
+					}
+					
+					examiner.expect(table.size()).to(be == connection_ids.size());
+					examiner.expect(table.insert(connection_ids[0], -1)).to(be == false);
+					
+					for (std::size_t index = 0; index < connection_ids.size(); index += 1) {
+						auto & connection_id = connection_ids[index];
+						auto value = table.find(connection_id.data.data(), connection_id.length);
+						
+						examiner.expect(value != nullptr).to(be == true);
+						if (value) examiner.expect(*value).to(be == (int)index);
+					}
+					
+					// Erase every other entry, which moves colliding entries back into the gaps:
+					for (std::size_t index = 0; index < connection_ids.size(); index += 2) {
+						auto & connection_id = connection_ids[index];
+						examiner.expect(table.erase(connection_id.data.data(), connection_id.length)).to(be == true);
+					}
+					
+					std::size_t found = 0, count = 0;
+					
+					for (std::size_t index = 0; index < connection_ids.size(); index += 1) {
+						auto & connection_id = connection_ids[index];
+						auto value = table.find(connection_id.data.data(), connection_id.length);
+						
+						if (index % 2) {
+							if (value && *value == (int)index) found += 1;
+						} else if (value) {
+							found += 1000;
+						}
+					}
+					
+					for (auto & slot : table) {
+						(void)slot;
+						count += 1;
+					}
+					
+					examiner.expect(found).to(be == connection_ids.size() / 2);
+					examiner.expect(count).to(be == table.size());
+				}
+			},
+			
+			{"it looks up one million connection IDs",
+				[](UnitTest::Examiner & examiner) {
+					const std::size_t count = 1000000;
+					
+					auto connection_ids = generate_connection_ids(count, DEFAULT_SCID_LENGTH);
+					
+					ConnectionIDTable<std::size_t> table;
+					std::unordered_map<std::string, std::size_t> map;
+					
+					for (std::size_t index = 0; index < count; index += 1) {
+						auto & connection_id = connection_ids[index];
+						
+						table.insert(connection_id, index);
+						map.emplace(std::string(reinterpret_cast<const char *>(connection_id.data.data()), connection_id.length), index);
+					}
+					
+					std::size_t table_found = 0, map_found = 0;
+					
+					auto table_time = measure_nanoseconds_per_lookup(count, [&]{
+						for (auto & connection_id : connection_ids) {
+							if (auto value = table.find(connection_id.data.data(), connection_id.length)) {
+								table_found += *value == table_found;
+							}
+						}
+					});
+					
+					auto map_time = measure_nanoseconds_per_lookup(count, [&]{
+						for (auto & connection_id : connection_ids) {
+							auto iterator = map.find(std::string(reinterpret_cast<const char *>(connection_id.data.data()), connection_id.length));
+							
+							if (iterator != map.end()) {
+								map_found += iterator->second == map_found;
+							}
+						}
+					});
+					
+					std::cerr << "ConnectionIDTable: " << table_time << " ns/lookup; std::unordered_map<std::string>: " << map_time << " ns/lookup" << std::endl;
+					
+					examiner.expect(table_found).to(be == count);
+					examiner.expect(map_found).to(be == count);
+				}
+			},
+		};
+	}
+}
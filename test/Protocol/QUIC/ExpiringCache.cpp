@@ -0,0 +1,78 @@
+//
+//  ExpiringCache.cpp
+//  This file is part of the "Protocol QUIC" project and released under the MIT License.
+//
+//  Created by Samuel Williams on 16/10/2026.
+//  Copyright, 2026, by Samuel Williams. All rights reserved.
+//
+
+#include <UnitTest/UnitTest.hpp>
+
+#include <Protocol/QUIC/ExpiringCache.hpp>
+
+namespace Protocol
+{
+	namespace QUIC
+	{
+		using namespace UnitTest::Expectations;
+		
+		static Address resolve(const char * host, const char * service = "4433")
+		{
+			return Address::resolve(host, service, AF_UNSPEC, SOCK_DGRAM, AI_NUMERICHOST).front();
+		}
+		
+		using Cache = ExpiringCache<int>;
+		
+		UnitTest::Suite ExpiringCacheTestSuite {
+			"Protocol::QUIC::ExpiringCache",
+			
+			{"it keys entries by address, and optionally port",
+				[](UnitTest::Examiner & examiner) {
+					Cache hosts(16, std::chrono::minutes(1), false);
+					hosts.store(resolve("192.0.2.1"), 1);
+					
+					examiner.expect(hosts.lookup(resolve("192.0.2.1", "443")).value_or(0)).to(be == 1);
+					examiner.expect(hosts.lookup(resolve("192.0.2.2")).has_value()).to(be == false);
+					
+					// An IPv6 address which starts with the same bytes is a different key:
+					examiner.expect(hosts.lookup(resolve("c000:201::")).has_value()).to(be == false);
+					
+					Cache servers(16, std::chrono::minutes(1), true);
+					servers.store(resolve("192.0.2.1"), 1);
+					
+					examiner.expect(servers.lookup(resolve("192.0.2.1", "443")).has_value()).to(be == false);
+					examiner.expect(servers.take(resolve("192.0.2.1")).value_or(0)).to(be == 1);
+					examiner.expect(servers.take(resolve("192.0.2.1")).has_value()).to(be == false);
+				}
+			},
+			
+			{"it expires entries",
+				[](UnitTest::Examiner & examiner) {
+					Cache cache(16, Cache::Clock::duration::zero(), false);
+					
+					cache.store(resolve("2001:db8::1"), 1);
+					examiner.expect(cache.lookup(resolve("2001:db8::1")).has_value()).to(be == false);
+					examiner.expect(cache.size()).to(be == 0);
+				}
+			},
+			
+			{"it evicts the oldest entry when full",
+				[](UnitTest::Examiner & examiner) {
+					Cache cache(2, std::chrono::minutes(1), false);
+					
+					cache.store(resolve("192.0.2.1"), 1);
+					cache.store(resolve("192.0.2.2"), 2);
+					
+					// Storing a value again makes it the newest:
+					cache.store(resolve("192.0.2.1"), 3);
+					cache.store(resolve("192.0.2.3"), 4);
+					
+					examiner.expect(cache.size()).to(be == 2);
+					examiner.expect(cache.lookup(resolve("192.0.2.1")).value_or(0)).to(be == 3);
+					examiner.expect(cache.lookup(resolve("192.0.2.2")).has_value()).to(be == false);
+					examiner.expect(cache.lookup(resolve("192.0.2.3")).value_or(0)).to(be == 4);
+				}
+			},
+		};
+	}
+}
@@ -0,0 +1,116 @@
+//
+//  PacketQueue.cpp
+//  This file is part of the "Protocol QUIC" project and released under the MIT License.
+//
+//  Created by Samuel Williams on 16/10/2026.
+//  Copyright, 2026, by Samuel Williams. All rights reserved.
+//
+
+#include <UnitTest/UnitTest.hpp>
+
+#include <Protocol/QUIC/PacketQueue.hpp>
+
+#include <thread>
+
+namespace Protocol
+{
+	namespace QUIC
+	{
+		using namespace UnitTest::Expectations;
+		
+		UnitTest::Suite PacketQueueTestSuite {
+			"Protocol::QUIC::PacketQueue",
+			
+			{"it queues packets in order and drops them when full",
+				[](UnitTest::Examiner & examiner) {
+					PacketQueue queue(4, 16);
+					Address local_address, remote_address;
+					
+					examiner.expect(queue.front() == nullptr).to(be == true);
+					
+					for (Byte index = 0; index < 4; index += 1) {
+						examiner.expect(queue.push(&index, 1, local_address, remote_address, ECN::CAPABLE_ECT_0, index)).to(be == true);
+					}
+					
+					Byte value = 4;
+					examiner.expect(queue.push(&value, 1, local_address, remote_address, ECN::UNSPECIFIED)).to(be == false);
+					
+					// Packets larger than a slot are dropped:
+					examiner.expect(queue.packet_size()).to(be == 16);
+					Byte large[32] = {};
+					examiner.expect(queue.push(large, sizeof(large), local_address, remote_address, ECN::UNSPECIFIED)).to(be == false);
+					
+					examiner.expect(queue.drops()).to(be == 2);
+					
+					for (Byte index = 0; index < 4; index += 1) {
+						auto packet = queue.front();
+						
+						examiner.expect(packet != nullptr).to(be == true);
+						if (!packet) return;
+						
+						examiner.expect(packet->size).to(be == 1);
+						examiner.expect(packet->data[0]).to(be == index);
+						examiner.expect(packet->receive_time).to(be == index);
+						examiner.expect(packet->ecn == ECN::CAPABLE_ECT_0).to(be == true);
+						
+						queue.pop();
+					}
+					
+					examiner.expect(queue.front() == nullptr).to(be == true);
+				}
+			},
+			
+			{"it hands packets from several threads to a waiting consumer",
+				[](UnitTest::Examiner & examiner) {
+					PacketQueue queue(64, 16);
+					
+					const std::size_t producers = 4, count = 10000;
+					std::vector<std::thread> threads;
+					
+					for (std::size_t producer = 0; producer < producers; producer += 1) {
+						threads.emplace_back([&, producer]{
+							Address local_address, remote_address;
+							
+							for (std::uint32_t index = 0; index < count;) {
+								std::uint32_t value[2] = {static_cast<std::uint32_t>(producer), index};
+								
+								if (queue.push(reinterpret_cast<Byte *>(value), sizeof(value), local_address, remote_address, ECN::UNSPECIFIED)) {
+									index += 1;
+								} else {
+									std::this_thread::yield();
+								}
+								
+								queue.notify();
+							}
+						});
+					}
+					
+					// Each producer's packets must arrive in order:
+					std::vector<std::uint32_t> next(producers);
+					std::size_t received = 0, ordered = 0;
+					
+					while (received < producers * count) {
+						queue.wait();
+						
+						while (auto packet = queue.front()) {
+							std::uint32_t value[2];
+							std::memcpy(value, packet->data, sizeof(value));
+							
+							if (value[0] < producers && value[1] == next[value[0]]) {
+								next[value[0]] += 1;
+								ordered += 1;
+							}
+							
+							received += 1;
+							queue.pop();
+						}
+					}
+					
+					for (auto & thread : threads) thread.join();
+					
+					examiner.expect(ordered).to(be == producers * count);
+				}
+			},
+		};
+	}
+}
@@ -0,0 +1,48 @@
+//
+//  PathMTUCache.cpp
+//  This file is part of the "Protocol QUIC" project and released under the MIT License.
+//
+//  Created by Samuel Williams on 16/10/2026.
+//  Copyright, 2026, by Samuel Williams. All rights reserved.
+//
+
+#include <UnitTest/UnitTest.hpp>
+
+#include <Protocol/QUIC/PathMTUCache.hpp>
+
+namespace Protocol
+{
+	namespace QUIC
+	{
+		using namespace UnitTest::Expectations;
+		
+		static std::vector<Address> resolve(const char * host, const char * service)
+		{
+			return Address::resolve(host, service, AF_UNSPEC, SOCK_DGRAM, AI_NUMERICHOST);
+		}
+		
+		UnitTest::Suite PathMTUCacheTestSuite {
+			"Protocol::QUIC::PathMTUCache",
+			
+			{"it remembers the learned size per host",
+				[](UnitTest::Examiner & examiner) {
+					PathMTUCache cache;
+					
+					cache.update(resolve("192.0.2.1", "4433").front(), 1452);
+					
+					// The port is ignored:
+					examiner.expect(cache.lookup(resolve("192.0.2.1", "443").front())).to(be == 1452);
+					examiner.expect(cache.lookup(resolve("192.0.2.2", "4433").front())).to(be == 0);
+					examiner.expect(cache.lookup(resolve("2001:db8::1", "4433").front())).to(be == 0);
+					
+					// Sizes which are no larger than the minimum were not confirmed by probing, and don't replace the learned size:
+					cache.update(resolve("192.0.2.1", "4433").front(), 1200);
+					examiner.expect(cache.lookup(resolve("192.0.2.1", "4433").front())).to(be == 1452);
+					
+					cache.erase(resolve("192.0.2.1", "4433").front());
+					examiner.expect(cache.lookup(resolve("192.0.2.1", "4433").front())).to(be == 0);
+				}
+			},
+		};
+	}
+}
@@ -0,0 +1,90 @@
+//
+//  RateLimiter.cpp
+//  This file is part of the "Protocol QUIC" project and released under the MIT License.
+//
+//  Created by Samuel Williams on 16/10/2026.
+//  Copyright, 2026, by Samuel Williams. All rights reserved.
+//
+
+#include <UnitTest/UnitTest.hpp>
+
+#include <Protocol/QUIC/RateLimiter.hpp>
+
+namespace Protocol
+{
+	namespace QUIC
+	{
+		using namespace UnitTest::Expectations;
+		
+		static std::vector<Address> resolve(const char * host, const char * service = "4433")
+		{
+			return Address::resolve(host, service, AF_UNSPEC, SOCK_DGRAM, AI_NUMERICHOST);
+		}
+		
+		static const std::uint64_t MILLISECOND = 1000 * 1000;
+		
+		UnitTest::Suite RateLimiterTestSuite {
+			"Protocol::QUIC::RateLimiter",
+			
+			{"it allows a burst and then refills at the rate",
+				[](UnitTest::Examiner & examiner) {
+					RateLimiter limiter(10, 2);
+					auto address = resolve("192.0.2.1").front();
+					
+					// A new prefix starts with a single token:
+					examiner.expect(limiter.allow(address, 0)).to(be == true);
+					examiner.expect(limiter.allow(address, 0)).to(be == false);
+					
+					// One token is added every 100ms, up to the burst:
+					examiner.expect(limiter.allow(address, 50 * MILLISECOND)).to(be == false);
+					examiner.expect(limiter.allow(address, 100 * MILLISECOND)).to(be == true);
+					examiner.expect(limiter.allow(address, 100 * MILLISECOND)).to(be == false);
+					
+					examiner.expect(limiter.allow(address, 1000 * MILLISECOND)).to(be == true);
+					examiner.expect(limiter.allow(address, 1000 * MILLISECOND)).to(be == true);
+					examiner.expect(limiter.allow(address, 1000 * MILLISECOND)).to(be == false);
+				}
+			},
+			
+			{"it groups sources by prefix",
+				[](UnitTest::Examiner & examiner) {
+					RateLimiter limiter(1, 1, RateLimiter::DEFAULT_CAPACITY, 24, 56);
+					
+					examiner.expect(limiter.allow(resolve("192.0.2.1").front(), 0)).to(be == true);
+					examiner.expect(limiter.allow(resolve("192.0.2.200", "443").front(), 0)).to(be == false);
+					examiner.expect(limiter.allow(resolve("192.0.3.1").front(), 0)).to(be == true);
+					
+					// IPv4-mapped addresses share the IPv4 prefix:
+					examiner.expect(limiter.allow(resolve("::ffff:192.0.2.9").front(), 0)).to(be == false);
+					
+					examiner.expect(limiter.allow(resolve("2001:db8:0:100::1").front(), 0)).to(be == true);
+					examiner.expect(limiter.allow(resolve("2001:db8:0:1ff::2").front(), 0)).to(be == false);
+					examiner.expect(limiter.allow(resolve("2001:db8:0:200::1").front(), 0)).to(be == true);
+				}
+			},
+			
+			{"it forgets the least recently used prefixes",
+				[](UnitTest::Examiner & examiner) {
+					// A single set of buckets:
+					RateLimiter limiter(1, 4, RateLimiter::WAYS);
+					examiner.expect(limiter.capacity()).to(be == RateLimiter::WAYS);
+					
+					// The bucket fills while the prefix is tracked:
+					auto address = resolve("192.0.2.1").front();
+					examiner.expect(limiter.allow(address, 0)).to(be == true);
+					examiner.expect(limiter.allow(address, 4000 * MILLISECOND)).to(be == true);
+					
+					// Enough other prefixes to replace every bucket:
+					for (std::size_t index = 1; index <= RateLimiter::WAYS; index += 1) {
+						auto other = resolve(("198.51." + std::to_string(index) + ".1").c_str()).front();
+						limiter.allow(other, 4000 * MILLISECOND + index * MILLISECOND);
+					}
+					
+					// The forgotten prefix starts again with a single token, rather than the burst it had accumulated:
+					examiner.expect(limiter.allow(address, 4010 * MILLISECOND)).to(be == true);
+					examiner.expect(limiter.allow(address, 4010 * MILLISECOND)).to(be == false);
+				}
+			},
+		};
+	}
+}
@@ -0,0 +1,606 @@
+//
+//  Socket.cpp
+//  This file is part of the "Protocol QUIC" project and released under the MIT License.
+//
+//  Created by Samuel Williams on 16/10/2026.
+//  Copyright, 2026, by Samuel Williams. All rights reserved.
+//
+
+#include <UnitTest/UnitTest.hpp>
+
+#include <Protocol/QUIC/Socket.hpp>
+#include <Protocol/QUIC/ReceiveBatch.hpp>
+#include <Protocol/QUIC/TransmitBatch.hpp>
+
+#include <array>
+#include <chrono>
+#include <iostream>
+#include <string_view>
+
+#include <time.h>
+
+namespace Protocol
+{
+	namespace QUIC
+	{
+		using namespace UnitTest::Expectations;
+		
+		// Bind the socket to an ephemeral port on the loopback interface.
+		static void bind_loopback(Socket & socket)
+		{
+			auto addresses = Address::resolve("127.0.0.1", "0", AF_INET, SOCK_DGRAM, AI_NUMERICHOST);
+			socket.bind(addresses.front());
+		}
+		
+		// Send count packets and measure how long it takes to receive them all.
+		template <typename Receive>
+		double measure_packets_per_second(Socket & sender, Socket & receiver, std::size_t rounds, std::size_t count, Receive receive)
+		{
+			std::array<Byte, 100> payload{};
+			auto start = std::chrono::steady_clock::now();
+			
+			for (std::size_t round = 0; round < rounds; round += 1) {
+				for (std::size_t index = 0; index < count; index += 1) {
+					sender.send_packet(payload.data(), payload.size(), receiver.local_address());
+				}
+				
+				std::size_t received = 0;
+				while (received < count) {
+					received += receive();
+				}
+			}
+			
+			std::chrono::duration<double> duration = std::chrono::steady_clock::now() - start;
+			
+			return (rounds * count) / duration.count();
+		}
+		
+		UnitTest::Suite SocketTestSuite {
+			"Protocol::QUIC::Socket",
+			
+			{"it can receive a batch of packets",
+				[](UnitTest::Examiner & examiner) {
+					Socket receiver(AF_INET), sender(AF_INET);
+					bind_loopback(receiver);
+					bind_loopback(sender);
+					
+					std::string_view messages[] = {"Hello", "World", "!"};
+					
+					for (auto message : messages) {
+						sender.send_packet(message.data(), message.size(), receiver.local_address());
+					}
+					
+					ReceiveBatch batch(8);
+					auto count = receiver.receive_packets(batch);
+					
+					examiner.expect(count).to(be == 3);
+					examiner.expect(batch.size()).to(be == 3);
+					
+					for (auto message : messages) {
+						auto packet = batch.next();
+						
+						examiner.expect(std::string_view(reinterpret_cast<const char *>(packet->data), packet->size)).to(be == message);
+						examiner.expect(packet->remote_address == sender.local_address()).to(be == true);
+					}
+					
+					examiner.expect(batch.next() == nullptr).to(be == true);
+					examiner.expect(batch.empty()).to(be == true);
+				}
+			},
+			
+			{"it can send a batch of packets to different destinations",
+				[](UnitTest::Examiner & examiner) {
+					Socket first(AF_INET), second(AF_INET), sender(AF_INET);
+					bind_loopback(first);
+					bind_loopback(second);
+					bind_loopback(sender);
+					
+					TransmitBatch transmit_batch;
+					transmit_batch.append("Hello", 5, first.local_address());
+					transmit_batch.append("World", 5, second.local_address(), ECN::CAPABLE_ECT_0);
+					transmit_batch.append("!", 1, first.local_address());
+					
+					examiner.expect(sender.send_packets(transmit_batch)).to(be == 3);
+					examiner.expect(transmit_batch.empty()).to(be == true);
+					
+					ReceiveBatch batch(8);
+					
+					examiner.expect(first.receive_packets(batch)).to(be == 2);
+					examiner.expect(second.receive_packets(batch)).to(be == 1);
+				}
+			},
+			
+			{"it marks each packet with its own ECN codepoint",
+				[](UnitTest::Examiner & examiner) {
+					Socket receiver(AF_INET), sender(AF_INET);
+					bind_loopback(receiver);
+					bind_loopback(sender);
+					
+					sender.send_packet("Hello", 5, receiver.local_address(), ECN::CAPABLE_ECT_0);
+					sender.send_packet("World", 5, receiver.local_address(), ECN::CAPABLE_ECT_1);
+					sender.send_packet("!", 1, receiver.local_address(), ECN::CAPABLE_ECT_0);
+					
+					ReceiveBatch batch(8);
+					examiner.expect(receiver.receive_packets(batch)).to(be == 3);
+					
+					for (auto ecn : {ECN::CAPABLE_ECT_0, ECN::CAPABLE_ECT_1, ECN::CAPABLE_ECT_0}) {
+						examiner.expect(batch.next()->ecn == ecn).to(be == true);
+					}
+					
+					examiner.expect(receiver.statistics().ect0).to(be == 2);
+					examiner.expect(receiver.statistics().ect1).to(be == 1);
+					examiner.expect(receiver.statistics().ce).to(be == 0);
+				}
+			},
+			
+			{"it replies from the local address of a dual-stack wildcard socket",
+				[](UnitTest::Examiner & examiner) {
+					Socket receiver(AF_INET6), sender(AF_INET);
+					
+					if (!receiver.set_dual_stack(true)) return;
+					receiver.bind(Address::resolve("::", "0", AF_INET6, SOCK_DGRAM, AI_PASSIVE|AI_NUMERICHOST).front());
+					bind_loopback(sender);
+					
+					auto addresses = Address::resolve("127.0.0.1", "0", AF_INET, SOCK_DGRAM, AI_NUMERICHOST);
+					auto & destination = addresses.front();
+					destination.data.in.sin_port = receiver.local_address().data.in6.sin6_port;
+					
+					sender.send_packet("Hello", 5, destination);
+					
+					ReceiveBatch batch(1);
+					examiner.expect(receiver.receive_packets(batch)).to(be == 1);
+					
+					// The packet was sent to the IPv4 loopback address, which is reported as an IPv4-mapped address:
+					auto packet = batch.next();
+					auto & local_address = packet->local_address;
+					examiner.expect(local_address.to_string()).to(be == "::ffff:127.0.0.1:" + std::to_string(ntohs(destination.data.in.sin_port)));
+					
+					Destination source = local_address;
+					receiver.send_packet("World", 5, packet->remote_address, ECN::UNSPECIFIED, nullptr, 0, 0, &source);
+					
+					std::array<Byte, 1024*64> buffer;
+					Address address;
+					ECN ecn;
+					
+					examiner.expect(sender.receive_packet(buffer.data(), buffer.size(), address, ecn)).to(be == 5);
+				}
+			},
+			
+			{"it marks packets exchanged with IPv4 peers on a dual-stack socket",
+				[](UnitTest::Examiner & examiner) {
+					Socket receiver(AF_INET6), sender(AF_INET);
+					
+					if (!receiver.set_dual_stack(true)) return;
+					receiver.bind(Address::resolve("::", "0", AF_INET6, SOCK_DGRAM, AI_PASSIVE|AI_NUMERICHOST).front());
+					bind_loopback(sender);
+					
+					auto addresses = Address::resolve("127.0.0.1", "0", AF_INET, SOCK_DGRAM, AI_NUMERICHOST);
+					auto & destination = addresses.front();
+					destination.data.in.sin_port = receiver.local_address().data.in6.sin6_port;
+					
+					sender.send_packet("Hello", 5, destination, ECN::CAPABLE_ECT_0);
+					
+					ReceiveBatch batch(1);
+					examiner.expect(receiver.receive_packets(batch)).to(be == 1);
+					
+					auto packet = batch.next();
+					examiner.expect(packet->ecn == ECN::CAPABLE_ECT_0).to(be == true);
+					examiner.expect(receiver.statistics().ect0).to(be == 1);
+					
+					// The reply to the IPv4-mapped address must be marked using `IP_TOS`:
+					receiver.send_packet("World", 5, packet->remote_address, ECN::CAPABLE_ECT_1);
+					
+					std::array<Byte, 1024*64> buffer;
+					Address address;
+					ECN ecn;
+					
+					examiner.expect(sender.receive_packet(buffer.data(), buffer.size(), address, ecn)).to(be == 5);
+					examiner.expect(ecn == ECN::CAPABLE_ECT_1).to(be == true);
+				}
+			},
+			
+			{"it records when the kernel received each packet",
+				[](UnitTest::Examiner & examiner) {
+					Socket receiver(AF_INET), sender(AF_INET);
+					bind_loopback(receiver);
+					bind_loopback(sender);
+					
+					sender.send_packet("Hello", 5, receiver.local_address());
+					
+					ReceiveBatch batch(1);
+					examiner.expect(receiver.receive_packets(batch)).to(be == 1);
+					
+					timespec now;
+					clock_gettime(CLOCK_MONOTONIC, &now);
+					
+					// Kernel timestamps are not available on all platforms:
+					auto packet = batch.next();
+					if (packet->receive_time == 0) return;
+					
+					examiner.expect(packet->receive_time).to(be <= now.tv_sec * 1000000000ull + now.tv_nsec);
+				}
+			},
+			
+			{"it reports dropped packets and grows the receive buffer",
+				[](UnitTest::Examiner & examiner) {
+					Socket receiver(AF_INET), sender(AF_INET);
+					bind_loopback(receiver);
+					bind_loopback(sender);
+					
+					receiver.set_receive_buffer_size(1024*4);
+					receiver.set_receive_buffer_limit(1024*1024);
+					auto size = receiver.receive_buffer_size();
+					
+					std::array<Byte, 1000> payload{};
+					
+					// Overflow the receive buffer:
+					for (std::size_t index = 0; index < 100; index += 1) {
+						sender.send_packet(payload.data(), payload.size(), receiver.local_address());
+					}
+					
+					examiner.expect(receiver.queue_depth()).to(be > 0);
+					
+					ReceiveBatch batch(100);
+					receiver.receive_packets(batch);
+					
+					// The kernel reports the number of drops with the next packet it queues:
+					sender.send_packet(payload.data(), payload.size(), receiver.local_address());
+					receiver.receive_packets(batch);
+					
+					// Drop accounting is not available on all platforms:
+					if (receiver.statistics().drops == 0) return;
+					
+					examiner.expect(receiver.receive_buffer_size()).to(be > size);
+				}
+			},
+			
+			{"it can busy poll for packets",
+				[](UnitTest::Examiner & examiner) {
+					Socket receiver(AF_INET), sender(AF_INET);
+					bind_loopback(receiver);
+					bind_loopback(sender);
+					
+					receiver.set_busy_poll(50);
+					examiner.expect(receiver.busy_poll()).to(be == 50);
+					
+					const std::size_t rounds = 100, count = 8;
+					ReceiveBatch batch(count);
+					
+					// Packets are received whether the socket spins or waits:
+					auto rate = measure_packets_per_second(sender, receiver, rounds, count, [&]{
+						return receiver.receive_packets(batch);
+					});
+					
+					examiner.expect(rate).to(be > 0);
+				}
+			},
+			
+			{"it delivers packets to a connected socket sharing the listening address",
+				[](UnitTest::Examiner & examiner) {
+					Socket listener(AF_INET), connected(AF_INET), sender(AF_INET), other(AF_INET);
+					
+					if (!listener.set_reuse_port(true)) return;
+					bind_loopback(listener);
+					bind_loopback(sender);
+					bind_loopback(other);
+					
+					connected.set_reuse_port(true);
+					examiner.expect(connected.bind(listener.local_address())).to(be == true);
+					examiner.expect(connected.connect(sender.local_address())).to(be == true);
+					
+					sender.send_packet("Hello", 5, listener.local_address());
+					other.send_packet("World", 5, listener.local_address());
+					
+					// The kernel prefers the socket connected to the sender:
+					ReceiveBatch batch(8);
+					examiner.expect(connected.receive_packets(batch)).to(be == 1);
+					examiner.expect(batch.next()->remote_address == sender.local_address()).to(be == true);
+					
+					examiner.expect(listener.receive_packets(batch)).to(be == 1);
+					examiner.expect(batch.next()->remote_address == other.local_address()).to(be == true);
+					
+					// Replies come from the shared address:
+					connected.send_packet("!", 1, sender.local_address());
+					
+					examiner.expect(sender.receive_packets(batch)).to(be == 1);
+					examiner.expect(batch.next()->remote_address == listener.local_address()).to(be == true);
+				}
+			},
+			
+			{"it steers short header packets to the socket named by the connection ID",
+				[](UnitTest::Examiner & examiner) {
+					Socket first(AF_INET), second(AF_INET), sender(AF_INET);
+					
+					if (!first.set_reuse_port(true)) return;
+					bind_loopback(first);
+					bind_loopback(sender);
+					
+					second.set_reuse_port(true);
+					examiner.expect(second.bind(first.local_address())).to(be == true);
+					
+					if (!first.set_reuse_port_steering(2)) return;
+					
+					// Short header packets, with the first byte of the destination connection ID selecting the socket:
+					for (Byte worker = 0; worker < 6; worker += 1) {
+						Byte packet[] = {0x40, worker, 0xAA, 0xBB, 0xCC, 0xDD, 0xEE, 0xFF, 0x00};
+						sender.send_packet(packet, sizeof(packet), first.local_address());
+					}
+					
+					ReceiveBatch batch(8);
+					
+					examiner.expect(first.receive_packets(batch)).to(be == 3);
+					while (auto packet = batch.next()) {
+						examiner.expect(packet->data[1] % 2).to(be == 0);
+					}
+					
+					examiner.expect(second.receive_packets(batch)).to(be == 3);
+					while (auto packet = batch.next()) {
+						examiner.expect(packet->data[1] % 2).to(be == 1);
+					}
+					
+					// Long header packets are distributed by the addresses, so they all reach the same socket:
+					for (std::size_t index = 0; index < 4; index += 1) {
+						Byte packet[] = {0xC0, 0x00, 0x00, 0x00, 0x01, 0x01, Byte(index)};
+						sender.send_packet(packet, sizeof(packet), first.local_address());
+					}
+					
+					Timestamp timeout = Timestamp() + Time::Interval::from_nanoseconds(100*1000*1000);
+					auto received = first.receive_packets(batch, &timeout);
+					if (received == 0) received = second.receive_packets(batch, &timeout);
+					
+					examiner.expect(received).to(be == 4);
+				}
+			},
+			
+			{"it can send the remainder of a partially sent batch",
+				[](UnitTest::Examiner & examiner) {
+					Socket receiver(AF_INET), sender(AF_INET);
+					bind_loopback(receiver);
+					bind_loopback(sender);
+					
+					TransmitBatch transmit_batch;
+					transmit_batch.append("Hello", 5, receiver.local_address());
+					transmit_batch.append("World", 5, receiver.local_address());
+					transmit_batch.append("!", 1, receiver.local_address());
+					
+					// As if the first packet had already been sent:
+					transmit_batch.consume(1);
+					examiner.expect(transmit_batch.size()).to(be == 2);
+					
+					examiner.expect(sender.send_packets(transmit_batch)).to(be == 2);
+					examiner.expect(sender.backlogged()).to(be == false);
+					
+					ReceiveBatch batch(8);
+					examiner.expect(receiver.receive_packets(batch)).to(be == 2);
+					
+					for (auto message : {"World", "!"}) {
+						auto packet = batch.next();
+						
+						examiner.expect(std::string_view(reinterpret_cast<const char *>(packet->data), packet->size)).to(be == message);
+					}
+				}
+			},
+			
+			{"it holds packets until flushed",
+				[](UnitTest::Examiner & examiner) {
+					Socket receiver(AF_INET), sender(AF_INET);
+					bind_loopback(receiver);
+					bind_loopback(sender);
+					
+					std::array<Byte, 1024*64> buffer;
+					Address address;
+					ECN ecn;
+					
+					sender.hold();
+					sender.send_packet("Hello", 5, receiver.local_address());
+					
+					// Nothing has been sent yet:
+					examiner.expect(::recv(receiver.descriptor(), buffer.data(), buffer.size(), MSG_DONTWAIT)).to(be == -1);
+					
+					sender.flush();
+					
+					examiner.expect(receiver.receive_packet(buffer.data(), buffer.size(), address, ecn)).to(be == 5);
+				}
+			},
+			
+			{"it can send a train of packets",
+				[](UnitTest::Examiner & examiner) {
+					Socket receiver(AF_INET), sender(AF_INET);
+					bind_loopback(receiver);
+					bind_loopback(sender);
+					
+					std::string_view train = "HelloWorld!";
+					
+					examiner.expect(sender.send_packet(train.data(), train.size(), receiver.local_address(), ECN::UNSPECIFIED, nullptr, 5)).to(be == train.size());
+					
+					// Each segment is received as a separate packet:
+					ReceiveBatch batch(8);
+					examiner.expect(receiver.receive_packets(batch)).to(be == 3);
+					
+					for (auto segment : {"Hello", "World", "!"}) {
+						auto packet = batch.next();
+						
+						examiner.expect(std::string_view(reinterpret_cast<const char *>(packet->data), packet->size)).to(be == segment);
+					}
+				}
+			},
+			
+			{"it receives coalesced packets individually",
+				[](UnitTest::Examiner & examiner) {
+					Socket receiver(AF_INET), sender(AF_INET);
+					bind_loopback(receiver);
+					bind_loopback(sender);
+					
+					std::string_view train = "HelloWorld!";
+					sender.send_packet(train.data(), train.size(), receiver.local_address(), ECN::UNSPECIFIED, nullptr, 5);
+					
+					std::array<Byte, 1024*64> buffer;
+					Address address;
+					ECN ecn;
+					
+					for (auto segment : {"Hello", "World", "!"}) {
+						auto size = receiver.receive_packet(buffer.data(), buffer.size(), address, ecn);
+						
+						examiner.expect(std::string_view(reinterpret_cast<const char *>(buffer.data()), size)).to(be == segment);
+						examiner.expect(address == sender.local_address()).to(be == true);
+					}
+				}
+			},
+			
+			{"it receives packets faster in batches",
+				[](UnitTest::Examiner & examiner) {
+					Socket receiver(AF_INET), sender(AF_INET);
+					bind_loopback(receiver);
+					bind_loopback(sender);
+					
+					const std::size_t rounds = 1000, count = 64;
+					
+					std::array<Byte, 1024*64> buffer;
+					Address address;
+					ECN ecn;
+					
+					auto individual = measure_packets_per_second(sender, receiver, rounds, count, [&]{
+						return receiver.receive_packet(buffer.data(), buffer.size(), address, ecn) ? 1 : 0;
+					});
+					
+					ReceiveBatch batch(count);
+					
+					auto batched = measure_packets_per_second(sender, receiver, rounds, count, [&]{
+						return receiver.receive_packets(batch);
+					});
+					
+					std::cerr << "receive_packet: " << individual << " packets/s; receive_packets: " << batched << " packets/s" << std::endl;
+					
+					examiner.expect(batched).to(be > 0);
+				}
+			},
+			
+			{"it can send packets with a departure time",
+				[](UnitTest::Examiner & examiner) {
+					Socket receiver(AF_INET), sender(AF_INET);
+					bind_loopback(receiver);
+					bind_loopback(sender);
+					
+					// Transmit times are not available on all platforms:
+					if (!sender.set_transmit_time(true)) return;
+					
+					timespec now;
+					clock_gettime(CLOCK_MONOTONIC, &now);
+					std::uint64_t departure_time = now.tv_sec * 1000000000ull + now.tv_nsec;
+					
+					examiner.expect(sender.send_packet("Hello", 5, receiver.local_address(), ECN::UNSPECIFIED, nullptr, 0, departure_time)).to(be == 5);
+					
+					ReceiveBatch batch(1);
+					examiner.expect(receiver.receive_packets(batch)).to(be == 1);
+				}
+			},
+			
+			{"it can send buffers without copying",
+				[](UnitTest::Examiner & examiner) {
+					Socket receiver(AF_INET), sender(AF_INET);
+					bind_loopback(receiver);
+					bind_loopback(sender);
+					
+					// Zero-copy is not available on all platforms:
+					if (!sender.set_zero_copy(true)) return;
+					
+					const std::size_t size = 1024*20;
+					
+					auto buffer = sender.buffer_pool().acquire();
+					std::fill_n(buffer.get(), size, 'Q');
+					
+					examiner.expect(sender.send_buffer(std::move(buffer), size, receiver.local_address())).to(be == size);
+					
+					ReceiveBatch batch(1);
+					examiner.expect(receiver.receive_packets(batch)).to(be == 1);
+					
+					auto packet = batch.next();
+					examiner.expect(packet->size).to(be == size);
+					examiner.expect(packet->data[size - 1]).to(be == 'Q');
+					
+					// Small packets are copied, and their buffers are returned to the pool immediately:
+					buffer = sender.buffer_pool().acquire();
+					examiner.expect(sender.send_buffer(std::move(buffer), 5, receiver.local_address())).to(be == 5);
+					examiner.expect(sender.buffer_pool().size()).to(be >= 1);
+				}
+			},
+			
+			{"it keeps its zero-copy state when moved",
+				[](UnitTest::Examiner & examiner) {
+					Socket receiver(AF_INET), sender(AF_INET);
+					bind_loopback(receiver);
+					bind_loopback(sender);
+					
+					if (!sender.set_zero_copy(true)) return;
+					
+					sender.buffer_pool().release(sender.buffer_pool().acquire());
+					
+					Socket moved(std::move(sender));
+					examiner.expect(moved.zero_copy()).to(be == true);
+					examiner.expect(moved.buffer_pool().size()).to(be == 1);
+					examiner.expect(sender.zero_copy()).to(be == false);
+					
+					auto buffer = moved.buffer_pool().acquire();
+					examiner.expect(moved.send_buffer(std::move(buffer), 1024*20, receiver.local_address())).to(be == 1024*20);
+				}
+			},
+			
+			{"it can send and receive packets using io_uring",
+				[](UnitTest::Examiner & examiner) {
+					Socket receiver(AF_INET), sender(AF_INET);
+					bind_loopback(receiver);
+					bind_loopback(sender);
+					
+					// The readiness backend is used if io_uring is not available:
+					if (receiver.set_backend(Socket::Backend::RING) != Socket::Backend::RING) return;
+					sender.set_backend(Socket::Backend::RING);
+					
+					TransmitBatch transmit_batch;
+					transmit_batch.append("Hello", 5, receiver.local_address());
+					transmit_batch.append("World", 5, receiver.local_address(), ECN::CAPABLE_ECT_0);
+					
+					examiner.expect(sender.send_packets(transmit_batch)).to(be == 2);
+					
+					ReceiveBatch batch(8);
+					std::size_t count = 0;
+					
+					while (count < 2) {
+						count += receiver.receive_packets(batch);
+						
+						while (auto packet = batch.next()) {
+							examiner.expect(packet->size).to(be == 5);
+							examiner.expect(packet->remote_address == sender.local_address()).to(be == true);
+						}
+					}
+					
+					examiner.expect(count).to(be == 2);
+				}
+			},
+			
+			{"it receives packets faster using io_uring",
+				[](UnitTest::Examiner & examiner) {
+					Socket receiver(AF_INET), sender(AF_INET);
+					bind_loopback(receiver);
+					bind_loopback(sender);
+					
+					const std::size_t rounds = 1000, count = 64;
+					ReceiveBatch batch(count);
+					
+					auto readiness = measure_packets_per_second(sender, receiver, rounds, count, [&]{
+						return receiver.receive_packets(batch);
+					});
+					
+					if (receiver.set_backend(Socket::Backend::RING) != Socket::Backend::RING) return;
+					
+					auto ring = measure_packets_per_second(sender, receiver, rounds, count, [&]{
+						return receiver.receive_packets(batch);
+					});
+					
+					std::cerr << "readiness: " << readiness << " packets/s; io_uring: " << ring << " packets/s" << std::endl;
+					
+					examiner.expect(ring).to(be > 0);
+				}
+			},
+		};
+	}
+}
@@ -0,0 +1,78 @@
+//
+//  TokenCache.cpp
+//  This file is part of the "Protocol QUIC" project and released under the MIT License.
+//
+//  Created by Samuel Williams on 16/10/2026.
+//  Copyright, 2026, by Samuel Williams. All rights reserved.
+//
+
+#include <UnitTest/UnitTest.hpp>
+
+#include <Protocol/QUIC/TokenCache.hpp>
+
+namespace Protocol
+{
+	namespace QUIC
+	{
+		using namespace UnitTest::Expectations;
+		
+		static Address resolve(const char * host, const char * service = "4433")
+		{
+			return Address::resolve(host, service, AF_UNSPEC, SOCK_DGRAM, AI_NUMERICHOST).front();
+		}
+		
+		static std::string token(const char * data)
+		{
+			// Tokens issued by `Server::submit_new_token` start with the regular token magic byte:
+			return std::string("\x36") + data;
+		}
+		
+		static void store(TokenCache & cache, const Address & address, const std::string & token)
+		{
+			cache.store(address, reinterpret_cast<const std::uint8_t *>(token.data()), token.size());
+		}
+		
+		UnitTest::Suite TokenCacheTestSuite {
+			"Protocol::QUIC::TokenCache",
+			
+			{"it presents each token only once",
+				[](UnitTest::Examiner & examiner) {
+					TokenCache cache;
+					store(cache, resolve("192.0.2.1"), token("first"));
+					
+					// Reusing a token would allow the two connections to be linked:
+					examiner.expect(cache.take(resolve("192.0.2.1"))).to(be == token("first"));
+					examiner.expect(cache.take(resolve("192.0.2.1"))).to(be == "");
+				}
+			},
+			
+			{"it keeps the most recent token from each server",
+				[](UnitTest::Examiner & examiner) {
+					TokenCache cache;
+					
+					// A server may issue several tokens during a connection, and only the latest is kept:
+					store(cache, resolve("192.0.2.1"), token("first"));
+					store(cache, resolve("192.0.2.1"), token("second"));
+					
+					// Servers sharing a host issue their own tokens:
+					store(cache, resolve("192.0.2.1", "443"), token("other"));
+					
+					examiner.expect(cache.size()).to(be == 2);
+					examiner.expect(cache.take(resolve("192.0.2.1"))).to(be == token("second"));
+					examiner.expect(cache.take(resolve("192.0.2.1", "443"))).to(be == token("other"));
+				}
+			},
+			
+			{"it ignores empty tokens",
+				[](UnitTest::Examiner & examiner) {
+					TokenCache cache;
+					store(cache, resolve("2001:db8::1"), token("first"));
+					
+					cache.store(resolve("2001:db8::1"), nullptr, 0);
+					
+					examiner.expect(cache.take(resolve("2001:db8::1"))).to(be == token("first"));
+				}
+			},
+		};
+	}
+}